@@ -0,0 +1,185 @@
+#include "Workloads.h"
+
+#include "Numeric.h"
+#include "OutputWriter.h" // OutputWriter::format_int
+
+namespace {
+
+/// splitmix64: small, fast and the same on every platform.
+class Random {
+    public:
+        explicit Random(std::uint64_t seed_) : state(seed_) {/* empty */}
+        std::uint64_t next() {
+            std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+        /// A number in [lo_, hi_].
+        int between(int lo_, int hi_) { return lo_ + static_cast<int>(next() % static_cast<std::uint64_t>(hi_ - lo_ + 1)); }
+        /// True with probability percent_ / 100.
+        bool chance(int percent_) { return between(1, 100) <= percent_; }
+
+    private:
+        std::uint64_t state;
+};
+
+const char *const names[] = {"flat", "chain", "nested", "unary", "errors"};
+
+void append_int(std::string &s_, Numeric::value_type v_) {
+    char digits[OutputWriter::max_int_chars];
+    char *end = digits + OutputWriter::max_int_chars;
+    s_.append(OutputWriter::format_int(end, v_), end);
+}
+
+char additive(Random &r_) { return r_.chance(50) ? '+' : '-'; }
+char any_operator(Random &r_) { return "+-*/%"[r_.between(0, 4)]; }
+
+//!< Linhas curtas: 2 a 5 termos
+std::string flat(Random &r_) {
+    std::string s;
+    append_int(s, r_.between(0, 999));
+    for (int i = r_.between(1, 4); i > 0; --i) {
+        s += ' ';
+        s += any_operator(r_);
+        s += ' ';
+        append_int(s, r_.between(1, 999));
+    }
+    return s;
+}
+
+//!< Cadeias longas de somas e subtrações de produtos pequenos
+std::string chain(Random &r_) {
+    std::string s;
+    for (int i = 0; i < 100; ++i) {
+        if (i > 0) {
+            s += ' ';
+            s += additive(r_);
+            s += ' ';
+        }
+        append_int(s, r_.between(1, 30));
+        if (r_.chance(30)) {
+            s += r_.chance(50) ? " * " : " / ";
+            append_int(s, r_.between(1, 30));
+        }
+    }
+    return s;
+}
+
+//!< Parênteses aninhados, 24 a 48 níveis
+std::string nested(Random &r_) {
+    int depth = r_.between(24, 48);
+    std::string s(static_cast<std::size_t>(depth), '(');
+    append_int(s, r_.between(1, 99));
+    for (int i = 0; i < depth; ++i) {
+        s += ' ';
+        s += additive(r_);
+        s += ' ';
+        append_int(s, r_.between(1, 99));
+        s += ')';
+    }
+    return s;
+}
+
+//!< Sequências de menos unários, separadas ou não por brancos
+std::string unary(Random &r_) {
+    std::string s;
+    for (int i = r_.between(2, 6); i > 0; --i) {
+        if (not s.empty()) {
+            s += ' ';
+            s += any_operator(r_);
+            s += ' ';
+        }
+        for (int k = r_.between(1, 6); k > 0; --k) {
+            s += '-';
+            if (r_.chance(40))
+                s += r_.chance(80) ? ' ' : '\t';
+        }
+        append_int(s, r_.between(1, 99));
+    }
+    return s;
+}
+
+//!< Erros de sintaxe e de avaliação, com algumas linhas válidas
+std::string errors(Random &r_) {
+    std::string s;
+    append_int(s, r_.between(1, 99));
+    switch (r_.between(0, 7)) {
+        case 0: // missing term
+            s += " + ";
+            break;
+        case 1: // extraneous symbol
+            s += " 3";
+            break;
+        case 2: // ill formed integer
+            s += " * a";
+            break;
+        case 3: // missing closing
+            s = "(" + s + " - 4";
+            break;
+        case 4: // integer out of range
+            s += " + 9";
+            s.append(static_cast<std::size_t>(sizeof(Numeric::value_type) * 3), '9');
+            break;
+        case 5: // division by zero
+            s += " / (7 - 7)";
+            break;
+        case 6: // numeric overflow
+            s += " + ";
+            append_int(s, Numeric::max());
+            break;
+        default: // valid
+            s += " % 7";
+            break;
+    }
+    return s;
+}
+
+} // namespace
+
+const char *Workloads::name(kind_t kind_) {
+    return names[static_cast<int>(kind_)];
+}
+
+bool Workloads::find(const std::string &name_, kind_t &kind_) {
+    for (std::size_t k = 0; k < n_kinds; ++k)
+        if (name_ == names[k]) {
+            kind_ = static_cast<kind_t>(k);
+            return true;
+        }
+    return false;
+}
+
+/*!
+ * Generates the input for one workload.
+ *
+ * \param kind_ The kind of lines.
+ * \param n_lines_ How many lines.
+ * \param seed_ The seed; each kind mixes in its own number, so kinds do not share sequences.
+ * \return The lines, without line breaks.
+ */
+Workloads::lines_type Workloads::generate(kind_t kind_, std::size_t n_lines_, std::uint64_t seed_) {
+    Random r(seed_ * 31 + static_cast<std::uint64_t>(kind_));
+    lines_type lines;
+    lines.reserve(n_lines_);
+    for (std::size_t i = 0; i < n_lines_; ++i) {
+        switch (kind_) {
+            case kind_t::FLAT:
+                lines.push_back(flat(r));
+                break;
+            case kind_t::CHAIN:
+                lines.push_back(chain(r));
+                break;
+            case kind_t::NESTED:
+                lines.push_back(nested(r));
+                break;
+            case kind_t::UNARY:
+                lines.push_back(unary(r));
+                break;
+            case kind_t::ERRORS:
+                lines.push_back(errors(r));
+                break;
+        }
+    }
+    return lines;
+}
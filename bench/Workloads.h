@@ -0,0 +1,39 @@
+#ifndef BARES_WORKLOADS_H
+#define BARES_WORKLOADS_H
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <string>  // std::string
+#include <vector>  // std::vector
+
+/*!
+ * Synthetic inputs for the benchmark.
+ *
+ * Each generator depends only on its seed (it uses its own pseudo-random numbers, not the
+ * standard distributions, whose results vary between libraries), so the same seed gives the
+ * same lines everywhere and results can be compared between runs and machines.
+ */
+class Workloads {
+    public:
+        typedef std::vector<std::string> lines_type;
+
+        /// The kinds of input.
+        enum class kind_t {
+            FLAT = 0, //!< Short lines with a few operators, as in the original test files.
+            CHAIN,    //!< Long chains of operators (about 100 terms per line).
+            NESTED,   //!< Deeply nested parentheses.
+            UNARY,    //!< Many runs of unary minus, with blanks between them.
+            ERRORS    //!< Mostly syntax errors, divisions by zero and overflows.
+        };
+        static const std::size_t n_kinds = 5;
+
+        /// Name of a kind, as used on the command line and in the results.
+        static const char *name(kind_t kind_);
+        /// Finds the kind called name_; returns false if there is none.
+        static bool find(const std::string &name_, kind_t &kind_);
+
+        /// Generates n_lines_ lines of the given kind.
+        static lines_type generate(kind_t kind_, std::size_t n_lines_, std::uint64_t seed_);
+};
+
+#endif //BARES_WORKLOADS_H
@@ -0,0 +1,203 @@
+#include <algorithm> // std::min
+#include <chrono>    // std::chrono::steady_clock
+#include <cstdio>    // std::printf
+#include <cstdlib>   // std::malloc, std::free, std::strtoull
+#include <iostream>  // std::cerr
+#include <new>       // std::bad_alloc
+#include <string>    // std::string
+#include <vector>    // std::vector
+
+#include "CompiledExpression.h"
+#include "Evaluator.h"
+#include "Numeric.h"
+#include "OutputWriter.h"
+#include "Parser.h"
+#include "Session.h"
+#include "Workloads.h"
+
+//=== Allocation counting: every operator new of the process goes through here.
+
+static std::size_t n_allocations = 0;
+
+void *operator new(std::size_t n_) {
+    ++n_allocations;
+    if (void *p = std::malloc(n_ > 0 ? n_ : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void operator delete(void *p_) noexcept { std::free(p_); }
+void *operator new[](std::size_t n_) { return operator new(n_); }
+void operator delete[](void *p_) noexcept { operator delete(p_); }
+
+namespace {
+
+/// Result of measuring one phase over one workload.
+struct Measure {
+    const char *workload;
+    const char *phase;
+    std::size_t lines;   //!< Lines handled by each run of the phase.
+    double seconds;      //!< Time of the fastest run.
+    std::size_t allocs;  //!< Allocations of the last run (caches and stacks are warm by then).
+
+    double ns_per_line() const { return lines > 0 ? seconds * 1e9 / static_cast<double>(lines) : 0.0; }
+    double lines_per_sec() const { return seconds > 0 ? static_cast<double>(lines) / seconds : 0.0; }
+    double allocs_per_line() const { return lines > 0 ? static_cast<double>(allocs) / static_cast<double>(lines) : 0.0; }
+};
+
+/// Keeps the results "used", so the compiler does not remove the work being measured.
+volatile long long sink = 0;
+
+/// Runs body_ once to warm up and then repeat_ times; keeps the fastest run.
+template <typename Body>
+Measure measure(const char *workload_, const char *phase_, std::size_t lines_, int repeat_, Body body_) {
+    body_();
+    Measure m{workload_, phase_, lines_, 0.0, 0};
+    for (int i = 0; i < repeat_; ++i) {
+        std::size_t before = n_allocations;
+        auto start = std::chrono::steady_clock::now();
+        body_();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        m.allocs = n_allocations - before;
+        m.seconds = i == 0 ? elapsed.count() : std::min(m.seconds, elapsed.count());
+    }
+    return m;
+}
+
+/// Measures every phase over one workload.
+void run_workload(Workloads::kind_t kind_, std::size_t n_lines_, std::uint64_t seed_, int repeat_,
+                  std::vector<Measure> &out_) {
+    const char *name = Workloads::name(kind_);
+    Workloads::lines_type lines = Workloads::generate(kind_, n_lines_, seed_);
+
+    // The later phases need the tokens and programs of the valid lines, prepared beforehand.
+    Parser parser;
+    Evaluator evaluator;
+    std::vector<Parser::token_list_type> tokens;
+    std::vector<CompiledExpression> programs;
+    for (const std::string &line : lines)
+        if (parser.parse(line).type == Parser::ResultType::OK) {
+            tokens.push_back(parser.get_tokens());
+            programs.push_back(evaluator.compile(parser.tokens()));
+        }
+
+    out_.push_back(measure(name, "parse", lines.size(), repeat_, [&]() {
+        long long n = 0;
+        for (const std::string &line : lines)
+            n += parser.parse(line).type;
+        sink = sink + n;
+    }));
+
+    CompiledExpression program;
+    out_.push_back(measure(name, "infix_to_postfix", tokens.size(), repeat_, [&]() {
+        long long n = 0;
+        for (const Parser::token_list_type &infix : tokens) {
+            evaluator.infix_to_postfix(infix, program);
+            n += static_cast<long long>(program.size());
+        }
+        sink = sink + n;
+    }));
+
+    out_.push_back(measure(name, "evaluate", programs.size(), repeat_, [&]() {
+        long long n = 0;
+        for (const CompiledExpression &postfix : programs)
+            n += static_cast<long long>(evaluator.evaluate(postfix).type_b);
+        sink = sink + n;
+    }));
+
+    // The whole path of the default mode, including formatting the output (into memory).
+    Session session;
+    OutputWriter text;
+    out_.push_back(measure(name, "session", lines.size(), repeat_, [&]() {
+        for (const std::string &line : lines) {
+            session.run(line, text);
+            text.clear();
+        }
+    }));
+}
+
+void print_text(const std::vector<Measure> &results_) {
+    std::printf("%-8s %-17s %9s %12s %14s %12s\n", "workload", "phase", "lines", "ns/line", "lines/s", "allocs/line");
+    for (const Measure &m : results_)
+        std::printf("%-8s %-17s %9zu %12.1f %14.0f %12.3f\n", m.workload, m.phase, m.lines, m.ns_per_line(),
+                    m.lines_per_sec(), m.allocs_per_line());
+}
+
+void print_csv(const std::vector<Measure> &results_) {
+    std::printf("workload,phase,int_bits,lines,seconds,ns_per_line,lines_per_sec,allocs_per_line\n");
+    for (const Measure &m : results_)
+        std::printf("%s,%s,%d,%zu,%.9f,%.3f,%.1f,%.6f\n", m.workload, m.phase, BARES_INT_BITS, m.lines, m.seconds,
+                    m.ns_per_line(), m.lines_per_sec(), m.allocs_per_line());
+}
+
+void print_json(const std::vector<Measure> &results_) {
+    std::printf("[\n");
+    for (std::size_t i = 0; i < results_.size(); ++i) {
+        const Measure &m = results_[i];
+        std::printf("  {\"workload\": \"%s\", \"phase\": \"%s\", \"int_bits\": %d, \"lines\": %zu, \"seconds\": %.9f, "
+                    "\"ns_per_line\": %.3f, \"lines_per_sec\": %.1f, \"allocs_per_line\": %.6f}%s\n",
+                    m.workload, m.phase, BARES_INT_BITS, m.lines, m.seconds, m.ns_per_line(), m.lines_per_sec(),
+                    m.allocs_per_line(), i + 1 < results_.size() ? "," : "");
+    }
+    std::printf("]\n");
+}
+
+} // namespace
+
+//!< Imprime a forma de uso do benchmark
+void usage() {
+    std::cerr << "Use: ./bares_bench [--lines N] [--repeat R] [--seed S] [--workload NOME]... [--format text|csv|json]\n"
+              << "  --lines N       linhas geradas por carga de trabalho (padrão 100000)\n"
+              << "  --repeat R      execuções medidas de cada fase; vale a mais rápida (padrão 5)\n"
+              << "  --seed S        semente do gerador; a mesma semente gera as mesmas linhas (padrão 1)\n"
+              << "  --workload NOME flat, chain, nested, unary ou errors (padrão: todas)\n"
+              << "  --format F      text (padrão), csv ou json\n";
+}
+
+//!< Método principal do benchmark
+int main(int argc, char *argv[]) {
+    std::size_t n_lines = 100000;
+    int repeat = 5;
+    std::uint64_t seed = 1;
+    std::string format = "text";
+    std::vector<Workloads::kind_t> kinds;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--lines" and i + 1 < argc)
+            n_lines = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--repeat" and i + 1 < argc)
+            repeat = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--seed" and i + 1 < argc)
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--format" and i + 1 < argc and
+                 (std::string(argv[i + 1]) == "text" or std::string(argv[i + 1]) == "csv" or
+                  std::string(argv[i + 1]) == "json"))
+            format = argv[++i];
+        else if (arg == "--workload" and i + 1 < argc) {
+            Workloads::kind_t kind;
+            if (not Workloads::find(argv[++i], kind)) {
+                usage();
+                return EXIT_FAILURE;
+            }
+            kinds.push_back(kind);
+        } else {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+    if (kinds.empty())
+        for (std::size_t k = 0; k < Workloads::n_kinds; ++k)
+            kinds.push_back(static_cast<Workloads::kind_t>(k));
+
+    std::vector<Measure> results;
+    for (Workloads::kind_t kind : kinds)
+        run_workload(kind, n_lines, seed, repeat, results);
+
+    if (format == "csv")
+        print_csv(results);
+    else if (format == "json")
+        print_json(results);
+    else
+        print_text(results);
+    return EXIT_SUCCESS;
+}
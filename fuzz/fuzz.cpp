@@ -0,0 +1,385 @@
+/*!
+ * Differential fuzzing of the evaluation engines.
+ *
+ * Random expressions, valid and invalid, are generated from the grammar in Parser.h and run
+ * through the reference (Parser + Evaluator, one line at a time, as Session does by default)
+ * and through every other engine and mode. All of them must write exactly the same text:
+ * the same values, the same error messages and the same columns. The time each engine takes
+ * on the same corpus is reported too, so a rewrite can be checked for speed as well.
+ *
+ * The process exits with failure at the first difference, printing the input line.
+ */
+
+#include <algorithm>  // std::min
+#include <chrono>     // std::chrono::steady_clock
+#include <cstdio>     // std::printf
+#include <cstdlib>    // std::strtoull, std::atoi
+#include <functional> // std::function
+#include <iostream>   // std::cerr
+#include <string>     // std::string
+#include <unistd.h>   // write, lseek, close, unlink, mkstemp
+#include <vector>     // std::vector
+
+#include "BatchRunner.h"
+#include "DagRunner.h"
+#include "LineReader.h"
+#include "Numeric.h"
+#include "OutputWriter.h"
+#include "PipelineRunner.h"
+#include "PushParser.h"
+#include "Scanner.h"
+#include "Session.h"
+#include "ShapeRunner.h"
+
+namespace {
+
+/// splitmix64, so that a seed gives the same corpus everywhere.
+class Random {
+    public:
+        explicit Random(std::uint64_t seed_) : state(seed_) {/* empty */}
+        std::uint64_t next() {
+            std::uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+        int between(int lo_, int hi_) { return lo_ + static_cast<int>(next() % static_cast<std::uint64_t>(hi_ - lo_ + 1)); }
+        bool chance(int percent_) { return between(1, 100) <= percent_; }
+
+    private:
+        std::uint64_t state;
+};
+
+/// Generates lines from the grammar, and then breaks some of them.
+class Generator {
+    public:
+        explicit Generator(std::uint64_t seed_) : r(seed_) {/* empty */}
+
+        std::string line() {
+            std::string s;
+            if (r.chance(2)) { // empty, or blanks only
+                blanks(s, 4);
+                return s;
+            }
+            blanks(s, 2);
+            expression(s, r.between(0, 4));
+            blanks(s, 2);
+            if (r.between(1, 1000) == 1)
+                nest(s);
+            if (r.chance(40))
+                mutate(s);
+            return s;
+        }
+
+    private:
+        Random r;
+
+        /// Sometimes adds a few spaces or tabs.
+        void blanks(std::string &s_, int max_) {
+            if (r.chance(25))
+                for (int i = r.between(1, max_); i > 0; --i)
+                    s_ += r.chance(80) ? ' ' : '\t';
+        }
+
+        // <expr> := <term>,{ <op>,<term> };
+        void expression(std::string &s_, int depth_) {
+            term(s_, depth_);
+            for (int i = r.between(0, 4); i > 0; --i) {
+                blanks(s_, 2);
+                s_ += "+-*/%^"[r.between(0, 5)];
+                blanks(s_, 2);
+                term(s_, depth_);
+            }
+        }
+
+        // <term> := "(",<expr>,")" | <integer>;
+        void term(std::string &s_, int depth_) {
+            if (depth_ > 0 and r.chance(20)) {
+                s_ += '(';
+                blanks(s_, 2);
+                expression(s_, depth_ - 1);
+                blanks(s_, 2);
+                s_ += ')';
+            } else
+                integer(s_);
+        }
+
+        // <integer> := 0 | {"-"},<natural_number>;
+        void integer(std::string &s_) {
+            if (r.chance(10)) {
+                s_ += '0';
+                return;
+            }
+            if (r.chance(30))
+                for (int i = r.between(1, 4); i > 0; --i) {
+                    s_ += '-';
+                    blanks(s_, 2);
+                }
+            natural(s_);
+        }
+
+        /// Small numbers, numbers near the limits of Numeric::value_type and numbers past them.
+        void natural(std::string &s_) {
+            char digits[OutputWriter::max_int_chars];
+            char *end = digits + OutputWriter::max_int_chars;
+            Numeric::value_type v;
+            int k = r.between(0, 9);
+            if (k < 6)
+                v = static_cast<Numeric::value_type>(r.between(1, 99));
+            else if (k < 8)
+                v = static_cast<Numeric::value_type>(r.between(100, 40000) % Numeric::max() + 1);
+            else
+                v = static_cast<Numeric::value_type>(Numeric::max() - r.between(0, 2));
+            s_.append(OutputWriter::format_int(end, v), end);
+            if (k == 9 and r.chance(50)) // past the limit, or far past it
+                s_.append(static_cast<std::size_t>(r.between(1, 3) * (r.chance(20) ? 10 : 1)), static_cast<char>('0' + r.between(0, 9)));
+        }
+
+        /// Wraps s_ in about as many parentheses as the parsers accept (a few more or less), some
+        /// of them after an operator.
+        void nest(std::string &s_) {
+            auto depth = static_cast<std::size_t>(BARES_MAX_NESTING - 2 + r.between(0, 4));
+            std::string open;
+            for (std::size_t i = 0; i < depth; ++i)
+                open += r.chance(5) ? "1+(" : "(";
+            s_ = open + s_ + std::string(depth, ')');
+        }
+
+        /// Breaks a line: removes, inserts, repeats or swaps a character, or cuts it short.
+        void mutate(std::string &s_) {
+            static const char alphabet[] = "+-*/%^() \t0123456789a.";
+            if (s_.empty())
+                return;
+            auto at = static_cast<std::size_t>(r.between(0, static_cast<int>(s_.size()) - 1));
+            switch (r.between(0, 4)) {
+                case 0:
+                    s_.erase(at, 1);
+                    break;
+                case 1:
+                    s_.insert(at, 1, alphabet[r.between(0, sizeof(alphabet) - 2)]);
+                    break;
+                case 2:
+                    s_.insert(at, 1, s_[at]);
+                    break;
+                case 3:
+                    if (at + 1 < s_.size())
+                        std::swap(s_[at], s_[at + 1]);
+                    break;
+                default:
+                    s_.resize(at);
+                    break;
+            }
+        }
+};
+
+/// One way of evaluating the corpus.
+struct Engine {
+    std::string name;
+    std::function<void(OutputWriter &)> run; //!< Evaluates the whole corpus into the writer.
+};
+
+/// Evaluates lines_ with a Session, one line at a time.
+void run_session(Session &session_, const std::vector<std::string> &lines_, OutputWriter &out_) {
+    for (const std::string &line : lines_)
+        session_.run(line, out_);
+}
+
+/// Text of line n_ (starting at 0) of out_.
+std::string line_of(const std::string &text_, std::size_t n_) {
+    std::size_t begin = 0;
+    for (; n_ > 0 and begin != std::string::npos; --n_) {
+        begin = text_.find('\n', begin);
+        if (begin != std::string::npos)
+            ++begin;
+    }
+    if (begin == std::string::npos)
+        return "<missing>";
+    return text_.substr(begin, text_.find('\n', begin) - begin);
+}
+
+/// Index of the first line where a_ and b_ differ.
+std::size_t first_difference(const std::string &a_, const std::string &b_) {
+    std::size_t line = 0;
+    for (std::size_t i = 0; i < a_.size() and i < b_.size() and a_[i] == b_[i]; ++i)
+        if (a_[i] == '\n')
+            ++line;
+    return line;
+}
+
+} // namespace
+
+//!< Imprime a forma de uso do fuzzer
+void usage() {
+    std::cerr << "Use: ./bares_fuzz [--lines N] [--rounds R] [--seed S] [--format text|csv]\n"
+              << "  --lines N   linhas por rodada (padrão 50000)\n"
+              << "  --rounds R  rodadas, cada uma com um corpus novo (padrão 4)\n"
+              << "  --seed S    semente da primeira rodada (padrão 1)\n"
+              << "  --format F  text (padrão) ou csv, para a vazão de cada engine\n";
+}
+
+//!< Método principal do fuzzer
+int main(int argc, char *argv[]) {
+    std::size_t n_lines = 50000;
+    int rounds = 4;
+    std::uint64_t seed = 1;
+    bool csv = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--lines" and i + 1 < argc)
+            n_lines = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--rounds" and i + 1 < argc)
+            rounds = std::atoi(argv[++i]);
+        else if (arg == "--seed" and i + 1 < argc)
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--format" and i + 1 < argc and std::string(argv[i + 1]) == "csv") {
+            csv = true;
+            ++i;
+        } else if (arg == "--format" and i + 1 < argc and std::string(argv[i + 1]) == "text")
+            ++i;
+        else {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+
+    // The runners read from a file, so the corpus is also written to a temporary one.
+    char path[] = "/tmp/bares_fuzz_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        std::cerr << "Não foi possível criar o arquivo temporário.\n";
+        return EXIT_FAILURE;
+    }
+    unlink(path);
+
+    std::vector<std::string> lines;
+    auto from_file = [&](std::function<void(LineReader &, OutputWriter &)> run_) {
+        return [fd, run_](OutputWriter &out_) {
+            lseek(fd, 0, SEEK_SET);
+            LineReader reader(fd);
+            run_(reader, out_);
+        };
+    };
+
+    // The reference comes first.
+    std::vector<Engine> engines;
+    const Scanner::isa_t best = Scanner::best_isa();
+    for (int isa = 0; isa <= static_cast<int>(best); ++isa) {
+        auto kind = static_cast<Scanner::isa_t>(isa);
+        std::string suffix = std::string("/") + Scanner::name(kind);
+        engines.push_back(Engine{"classic" + suffix, [&lines, kind](OutputWriter &out_) {
+            Scanner::set_isa(kind);
+            Session session;
+            run_session(session, lines, out_);
+        }});
+        engines.push_back(Engine{"fused" + suffix, [&lines, kind](OutputWriter &out_) {
+            Scanner::set_isa(kind);
+            Session session(Session::engine_t::FUSED);
+            run_session(session, lines, out_);
+        }});
+    }
+    engines.push_back(Engine{"cache", [&lines, best](OutputWriter &out_) {
+        Scanner::set_isa(best);
+        Session session(Session::engine_t::CLASSIC, 256);
+        run_session(session, lines, out_);
+    }});
+    engines.push_back(Engine{"push", [&lines, best, seed](OutputWriter &out_) {
+        // The corpus is pushed in chunks of random sizes, cut anywhere in the lines.
+        Scanner::set_isa(best);
+        std::string text;
+        for (const std::string &line : lines)
+            text.append(line).append(1, '\n');
+        Random r(seed);
+        Session session;
+        PushParser parser;
+        const char *first = text.data();
+        const char *end = first + text.size();
+        while (first != end) {
+            const char *last = first + std::min<std::size_t>(static_cast<std::size_t>(end - first),
+                                                             static_cast<std::size_t>(r.chance(10) ? 1 : r.between(1, 200)));
+            while (first != last) {
+                first = parser.push(first, last);
+                if (parser.ready())
+                    session.run(parser, out_);
+            }
+        }
+        if (parser.finish())
+            session.run(parser, out_);
+    }});
+    engines.push_back(Engine{"jobs4", from_file([](LineReader &in_, OutputWriter &out_) {
+        BatchRunner(4, Session::engine_t::CLASSIC, 0, 4096).run(in_, out_);
+    })});
+    engines.push_back(Engine{"jobs4-fused", from_file([](LineReader &in_, OutputWriter &out_) {
+        BatchRunner(4, Session::engine_t::FUSED, 0, 4096).run(in_, out_);
+    })});
+    engines.push_back(Engine{"pipeline4", [fd](OutputWriter &out_) {
+        // Small blocks, so that lines are often cut between two of them.
+        lseek(fd, 0, SEEK_SET);
+        PipelineRunner(4, Session::engine_t::CLASSIC, 0, 4096, 2).run(fd, out_);
+    }});
+    engines.push_back(Engine{"dag", from_file([](LineReader &in_, OutputWriter &out_) {
+        DagRunner().run(in_, out_);
+    })});
+    engines.push_back(Engine{"shapes", from_file([](LineReader &in_, OutputWriter &out_) {
+        ShapeRunner().run(in_, out_);
+    })});
+
+    std::vector<double> seconds(engines.size(), 0.0);
+    std::size_t total_lines = 0;
+    OutputWriter reference, candidate;
+
+    for (int round = 0; round < rounds; ++round) {
+        Generator generator(seed + static_cast<std::uint64_t>(round));
+        lines.clear();
+        std::string text;
+        for (std::size_t i = 0; i < n_lines; ++i) {
+            lines.push_back(generator.line());
+            text += lines.back();
+            text += '\n';
+        }
+        if (ftruncate(fd, 0) != 0 or lseek(fd, 0, SEEK_SET) != 0
+            or write(fd, text.data(), text.size()) != static_cast<ssize_t>(text.size())) {
+            std::cerr << "Não foi possível escrever o arquivo temporário.\n";
+            return EXIT_FAILURE;
+        }
+        total_lines += lines.size();
+
+        for (std::size_t e = 0; e < engines.size(); ++e) {
+            OutputWriter &out = e == 0 ? reference : candidate;
+            out.clear();
+            auto start = std::chrono::steady_clock::now();
+            engines[e].run(out);
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            seconds[e] += elapsed.count();
+
+            if (e == 0)
+                continue;
+            std::string expected(reference.data(), reference.size());
+            std::string got(candidate.data(), candidate.size());
+            if (got != expected) {
+                std::size_t n = first_difference(expected, got);
+                std::cerr << "DIFERENÇA: engine " << engines[e].name << ", semente " << seed + round
+                          << ", linha " << n + 1 << "\n"
+                          << "  entrada:  \"" << (n < lines.size() ? lines[n] : "") << "\"\n"
+                          << "  esperado: " << line_of(expected, n) << "\n"
+                          << "  obtido:   " << line_of(got, n) << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    close(fd);
+
+    if (csv)
+        std::printf("engine,int_bits,lines,seconds,lines_per_sec\n");
+    else
+        std::printf("%zu lines, %d rounds: every engine matches %s\n%-16s %12s %14s\n", total_lines, rounds,
+                    engines[0].name.c_str(), "engine", "seconds", "lines/s");
+    for (std::size_t e = 0; e < engines.size(); ++e) {
+        double rate = seconds[e] > 0 ? static_cast<double>(total_lines) / seconds[e] : 0.0;
+        if (csv)
+            std::printf("%s,%d,%zu,%.6f,%.1f\n", engines[e].name.c_str(), BARES_INT_BITS, total_lines, seconds[e], rate);
+        else
+            std::printf("%-16s %12.4f %14.0f\n", engines[e].name.c_str(), seconds[e], rate);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,129 @@
+#ifndef BARES_ARENA_H
+#define BARES_ARENA_H
+
+#include <cstddef> // std::size_t
+#include <new>         // operator new
+#include <type_traits> // std::false_type
+#include <vector>      // std::vector
+
+/*!
+ * A bump allocator for short-lived data.
+ *
+ * Memory is handed out from large blocks by moving a pointer forward; individual
+ * deallocations do nothing. reset() makes the whole arena available again without
+ * returning the blocks to the system, so once the arena has grown to the size needed by
+ * the largest line, processing further lines performs no malloc()/free() at all.
+ *
+ * Containers that use an ArenaAllocator must not touch their old memory after reset();
+ * see arena_recycle().
+ */
+class Arena {
+    public:
+        /// Default size of each block, in bytes.
+        static const std::size_t default_block_size = 64 * 1024;
+
+        /// Creates an empty arena; blocks are allocated on demand.
+        explicit Arena(std::size_t block_size_ = default_block_size);
+        /// Returns every block to the system.
+        ~Arena();
+        /// Turn off copy constructor. We do not need it.
+        Arena(const Arena &) = delete;
+        /// Turn off assignment operator.
+        Arena &operator=(const Arena &) = delete;
+
+        /// Returns n_ bytes aligned to align_ (a power of two).
+        void *allocate(std::size_t n_, std::size_t align_);
+        /// Makes all the memory available again (the blocks are kept).
+        void reset();
+
+        /// Number of allocate() calls since the arena was created.
+        std::size_t allocations() const { return n_allocations; }
+        /// Number of blocks requested from the system (malloc) since the arena was created.
+        std::size_t system_allocations() const { return blocks.size(); }
+        /// Number of reset() calls.
+        std::size_t resets() const { return n_resets; }
+        /// Bytes handed out since the last reset().
+        std::size_t bytes_in_use() const;
+        /// Total size of the blocks owned by the arena.
+        std::size_t capacity() const;
+
+    private:
+        /// A chunk of memory obtained from the system.
+        struct Block {
+            char *data;
+            std::size_t size;
+        };
+
+        std::size_t block_size;     //!< Minimum size of a new block.
+        std::vector<Block> blocks;  //!< Every block ever allocated.
+        std::size_t curr = 0;       //!< Block being used.
+        std::size_t offset = 0;     //!< First free byte in blocks[curr].
+        std::size_t n_allocations = 0;
+        std::size_t n_resets = 0;
+
+        std::size_t aligned(const Block &b_, std::size_t align_) const;
+};
+
+/*!
+ * Standard allocator that draws from an Arena.
+ *
+ * A default-constructed allocator (no arena) uses the global operator new/delete, so the
+ * same container type works with and without an arena. Copies of a container get the
+ * default allocator, so they never outlive the arena.
+ */
+template <typename T>
+class ArenaAllocator {
+    public:
+        typedef T value_type;
+        typedef std::false_type propagate_on_container_copy_assignment;
+        typedef std::false_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+
+        ArenaAllocator() = default;
+        explicit ArenaAllocator(Arena *arena_) : pool(arena_) {/* empty */}
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U> &other_) : pool(other_.arena()) {/* empty */}
+
+        T *allocate(std::size_t n_) {
+            if (pool == nullptr)
+                return static_cast<T *>(::operator new(n_ * sizeof(T)));
+            return static_cast<T *>(pool->allocate(n_ * sizeof(T), alignof(T)));
+        }
+        void deallocate(T *p_, std::size_t) {
+            if (pool == nullptr)
+                ::operator delete(p_);
+            // Arena memory is released all at once by Arena::reset().
+        }
+
+        /// Copies of a container do not share the arena.
+        ArenaAllocator select_on_container_copy_construction() const { return ArenaAllocator(); }
+
+        /// The arena, or nullptr if the global heap is used.
+        Arena *arena() const { return pool; }
+
+    private:
+        Arena *pool = nullptr;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T> &a_, const ArenaAllocator<U> &b_) { return a_.arena() == b_.arena(); }
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T> &a_, const ArenaAllocator<U> &b_) { return a_.arena() != b_.arena(); }
+
+/*!
+ * Prepares a container to be filled again, with room for n_ elements.
+ *
+ * A heap-backed container is just cleared, keeping its capacity. An arena-backed container
+ * drops its buffer instead (its arena may have been reset since it was filled) and reserves
+ * a new one from the arena.
+ */
+template <typename V>
+void arena_recycle(V &v_, std::size_t n_) {
+    if (v_.get_allocator().arena() != nullptr)
+        V(v_.get_allocator()).swap(v_);
+    else
+        v_.clear();
+    v_.reserve(n_);
+}
+
+#endif //BARES_ARENA_H
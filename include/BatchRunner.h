@@ -0,0 +1,60 @@
+#ifndef BARES_BATCHRUNNER_H
+#define BARES_BATCHRUNNER_H
+
+#include <cstddef>  // std::size_t
+#include <memory>   // std::unique_ptr
+#include <string>   // std::string
+#include <vector>   // std::vector
+
+#include "LineReader.h"
+#include "OutputWriter.h"
+#include "Session.h"
+#include "ThreadPool.h"
+
+/*!
+ * Evaluates the input on a pool of worker threads, keeping the output in input order.
+ *
+ * Lines are read in batches of `batch_lines`. Each batch is cut into chunks of `grain`
+ * lines that are evaluated as independent tasks; the text of every chunk is kept apart
+ * and written in chunk order once the whole batch is done. While the workers evaluate
+ * one batch, the calling thread reads the next one, so memory is bounded by two batches.
+ */
+class BatchRunner {
+    public:
+        /// Creates a runner with n_jobs worker threads, each one with a session that uses the engine e_
+        /// and a result cache of cache_size_ entries (none if 0).
+        explicit BatchRunner(std::size_t n_jobs, Session::engine_t e_ = Session::engine_t::CLASSIC,
+                             std::size_t cache_size_ = 0, std::size_t batch_lines_ = 16384, std::size_t grain_ = 256);
+        /// Default destructor
+        ~BatchRunner() = default;
+        /// Turn off copy constructor. We do not need it.
+        BatchRunner(const BatchRunner &) = delete;
+        /// Turn off assignment operator.
+        BatchRunner &operator=(const BatchRunner &) = delete;
+
+        /// Evaluates every line from reader_ and writes the results to out_.
+        void run(LineReader &reader_, OutputWriter &out_);
+
+        /// Number of worker sessions.
+        std::size_t workers() const { return sessions.size(); }
+        /// The session used by worker i_.
+        const Session &session(std::size_t i_) const { return *sessions[i_]; }
+
+    private:
+        /// Lines of one batch and the output of each of its chunks.
+        struct Batch {
+            std::vector<std::string> lines;
+            std::size_t size = 0;
+            std::vector<std::unique_ptr<OutputWriter>> output; //!< Memory writers, reused across batches.
+        };
+
+        std::size_t batch_lines;                        //!< Lines read per batch.
+        std::size_t grain;                              //!< Lines evaluated per task.
+        ThreadPool pool;                                //!< The worker threads.
+        std::vector<std::unique_ptr<Session>> sessions; //!< One session per worker.
+
+        void read_batch(LineReader &reader_, Batch &b_);
+        void dispatch(Batch &b_);
+};
+
+#endif //BARES_BATCHRUNNER_H
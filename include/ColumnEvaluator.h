@@ -0,0 +1,49 @@
+#ifndef BARES_COLUMNEVALUATOR_H
+#define BARES_COLUMNEVALUATOR_H
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint8_t
+#include <vector>  // std::vector
+
+#include "CompiledExpression.h"
+#include "Evaluator.h"
+
+/*!
+ * Evaluates one postfix shape over many sets of operands at once (structure of arrays).
+ *
+ * The program reads its per-lane operands with LOAD instructions: "LOAD k" pushes column k,
+ * which holds one value per lane. A PUSH is the same constant for every lane. Each
+ * operation is applied to whole columns, so "+", "-" and "*" run as branch-free loops that
+ * the compiler turns into SIMD code (with AVX2 and SSE2 versions chosen at run time, where
+ * supported). "/", "%" and "^" go through Evaluator::execute_operator() lane by lane.
+ *
+ * Every lane keeps its own error code, with the same meaning as EvaluatorResult::code: the
+ * first error of a lane (in postfix order) is the one reported.
+ */
+class ColumnEvaluator {
+    public:
+        typedef Numeric::value_type lane_type; //!< Type of one operand of one lane.
+        typedef std::uint8_t code_type;   //!< An EvaluatorResult::code, stored in one byte.
+
+        /*!
+         * Evaluates shape_ over lanes_ lanes.
+         *
+         * \param shape_ The postfix program.
+         * \param columns_ The columns (lanes_ values each) read by the LOAD instructions of shape_.
+         * \param lanes_ Number of lanes.
+         * \param values_ Receives the value of each lane (meaningful only when its code is OK).
+         * \param codes_ Receives the EvaluatorResult::code of each lane.
+         */
+        void evaluate(const CompiledExpression &shape_, const lane_type *const *columns_, std::size_t lanes_,
+                      lane_type *values_, code_type *codes_);
+
+    private:
+        std::vector<lane_type> buffers;      //!< Two writable columns per stack slot.
+        std::vector<const lane_type *> slots; //!< The column each stack slot refers to.
+        Evaluator evaluator;                 //!< Scalar fallback for "/", "%" and "^".
+
+        void scalar_kernel(Token::operator_t op_, const lane_type *a_, const lane_type *b_, lane_type *out_,
+                           code_type *codes_, std::size_t n_);
+};
+
+#endif //BARES_COLUMNEVALUATOR_H
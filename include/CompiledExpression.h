@@ -0,0 +1,123 @@
+#ifndef BARES_COMPILEDEXPRESSION_H
+#define BARES_COMPILEDEXPRESSION_H
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint8_t
+#include <vector>  // std::vector
+
+#include "Token.h"
+#include "Arena.h"
+
+/*!
+ * A compiled expression: a flat postfix program that can be evaluated many times.
+ *
+ * It is produced from the tokens of a successful Parser::parse() by
+ * Evaluator::infix_to_postfix() (or Evaluator::compile()) and run by
+ * Evaluator::evaluate(const CompiledExpression &), which neither parses nor allocates.
+ * A compiled expression is never modified by evaluation, so one instance can be shared
+ * by several threads, each with its own Evaluator.
+ */
+class CompiledExpression {
+    public:
+        /// Operation codes. Binary operators have the same values as the matching Token::operator_t.
+        enum class opcode_t : std::uint8_t {
+            PUSH = 0, //!< Pushes the immediate operand.
+            ADD,      //!< "+"
+            SUB,      //!< "-"
+            MUL,      //!< "*"
+            DIV,      //!< "/"
+            MOD,      //!< "%"
+            POW,      //!< "^"
+            LOAD      //!< Pushes the variable whose index is the immediate operand.
+        };
+
+        /// One instruction of the postfix program.
+        struct Instruction {
+            Token::value_type operand; //!< Immediate value (opcode_t::PUSH) or variable index (opcode_t::LOAD).
+            opcode_t op;               //!< What to do.
+        };
+
+        typedef std::vector<Instruction, ArenaAllocator<Instruction>> code_type;
+        typedef code_type::const_iterator const_iterator;
+
+        /// Creates an empty program. If arena_ is given, the instructions are allocated from it;
+        /// copies of the program always use the heap.
+        explicit CompiledExpression(Arena *arena_ = nullptr) : code(ArenaAllocator<Instruction>(arena_)) {/* empty */}
+
+        /// Converts a binary operator token code into its opcode.
+        static opcode_t opcode(Token::operator_t op_) { return static_cast<opcode_t>(op_); }
+        /// Converts a binary opcode back into the operator token code.
+        static Token::operator_t operator_of(opcode_t op_) { return static_cast<Token::operator_t>(op_); }
+
+        /// Appends an instruction that pushes value_.
+        void push(Token::value_type value_) {
+            code.push_back(Instruction{value_, opcode_t::PUSH});
+            if (++depth > max_depth)
+                max_depth = depth;
+        }
+        /// Appends an instruction that pushes the variable number index_.
+        void load(Token::value_type index_) {
+            code.push_back(Instruction{index_, opcode_t::LOAD});
+            if (++depth > max_depth)
+                max_depth = depth;
+        }
+        /// Appends a binary operation.
+        void emit(opcode_t op_) {
+            code.push_back(Instruction{0, op_});
+            --depth;
+        }
+        /// Removes every instruction, keeping the allocated memory (unless it comes from an arena).
+        void clear() {
+            arena_recycle(code, 0);
+            depth = max_depth = 0;
+        }
+
+        const_iterator begin() const { return code.begin(); }
+        const_iterator end() const { return code.end(); }
+        const Instruction *data() const { return code.data(); }
+        std::size_t size() const { return code.size(); }
+        bool empty() const { return code.empty(); }
+        /// Number of values the evaluation stack must be able to hold.
+        std::size_t max_stack_depth() const { return max_depth; }
+
+        /// Reserves room for n_ instructions.
+        void reserve(std::size_t n_) { code.reserve(n_); }
+
+        /// Hash of the program (FNV-1a over the instructions).
+        /*!
+         * The postfix form does not keep white spaces nor parentheses, so expressions that only
+         * differ in spacing or in redundant parentheses, such as "(2+3)*4" and "((2 + 3)) * 4",
+         * compile into the same program and have the same hash.
+         */
+        std::size_t hash() const {
+            std::uint64_t h = 14695981039346656037ull;
+            for (const Instruction &ins : code) {
+                std::uint64_t word = Numeric::fold(ins.operand);
+                for (int i = 0; i < 8; ++i, word >>= 8)
+                    h = (h ^ (word & 0xffu)) * 1099511628211ull;
+                h = (h ^ static_cast<std::uint8_t>(ins.op)) * 1099511628211ull;
+            }
+            return static_cast<std::size_t>(h);
+        }
+
+        /// Two programs are equal if they have the same instructions.
+        friend bool operator==(const CompiledExpression &a_, const CompiledExpression &b_) {
+            if (a_.code.size() != b_.code.size())
+                return false;
+            for (std::size_t i = 0; i < a_.code.size(); ++i)
+                if (a_.code[i].op != b_.code[i].op or a_.code[i].operand != b_.code[i].operand)
+                    return false;
+            return true;
+        }
+        friend bool operator!=(const CompiledExpression &a_, const CompiledExpression &b_) { return not(a_ == b_); }
+
+    private:
+        code_type code;                //!< The postfix program.
+        std::size_t depth = 0;         //!< Stack depth after the last instruction.
+        std::size_t max_depth = 0;     //!< Deepest stack reached by the program.
+};
+
+static_assert(static_cast<int>(CompiledExpression::opcode_t::POW) == static_cast<int>(Token::operator_t::CIRCUMFLEX),
+              "binary opcodes must match Token::operator_t");
+
+#endif //BARES_COMPILEDEXPRESSION_H
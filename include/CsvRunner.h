@@ -0,0 +1,67 @@
+#ifndef BARES_CSVRUNNER_H
+#define BARES_CSVRUNNER_H
+
+#include <cstddef> // std::size_t
+#include <string>  // std::string
+#include <vector>  // std::vector
+
+#include "ColumnEvaluator.h"
+#include "CompiledExpression.h"
+#include "LineReader.h"
+#include "OutputWriter.h"
+#include "Parser.h"
+
+/*!
+ * Evaluates one expression with named variables over every row of a CSV input.
+ *
+ * The first line of the input is a header with the column names; each variable of the
+ * expression takes its value from the column with the same name. The rows are read in blocks
+ * of `block_rows`; the fields used by the expression are stored column-wise and the whole
+ * block is evaluated by a ColumnEvaluator, so the expression is parsed and compiled only once.
+ *
+ * Each row gives one output line: the value, an evaluation error, or a syntax error when one
+ * of the fields used is not an integer (its column is the position of the field in the row).
+ */
+class CsvRunner {
+    public:
+        /// Creates a runner that evaluates program_, whose variables are named variables_.
+        CsvRunner(const CompiledExpression &program_, const std::vector<std::string> &variables_,
+                  std::size_t block_rows_ = 4096);
+        /// Default destructor
+        ~CsvRunner() = default;
+        /// Turn off copy constructor. We do not need it.
+        CsvRunner(const CsvRunner &) = delete;
+        /// Turn off assignment operator.
+        CsvRunner &operator=(const CsvRunner &) = delete;
+
+        /// Reads the header from reader_ and finds the column of each variable.
+        /*!
+         * \return true on success; otherwise false, with the name of a variable without column in missing_.
+         */
+        bool open(LineReader &reader_, std::string &missing_);
+        /// Evaluates every row from reader_ (after open()) and writes the results to out_.
+        void run(LineReader &reader_, OutputWriter &out_);
+
+        /// Number of rows processed.
+        std::size_t rows() const { return n_rows; }
+
+    private:
+        typedef ColumnEvaluator::lane_type lane_type;
+
+        Parser::ResultType read_row(const std::string &row_, std::size_t lane_);
+
+        CompiledExpression program;           //!< The compiled expression.
+        std::vector<std::string> names;       //!< Name of each variable.
+        std::vector<int> field_variable;      //!< Variable read from each field of a row (-1: none).
+        std::size_t block_rows;               //!< Rows per block.
+        ColumnEvaluator columns;
+        std::vector<lane_type> column_data;   //!< Values of the variables of the block, column by column.
+        std::vector<const lane_type *> column_ptrs;
+        std::vector<Parser::ResultType> parsed; //!< Outcome of reading each row of the block.
+        std::vector<lane_type> values;
+        std::vector<ColumnEvaluator::code_type> codes;
+        std::string row;                      //!< The current input line.
+        std::size_t n_rows = 0;
+};
+
+#endif //BARES_CSVRUNNER_H
@@ -0,0 +1,56 @@
+#ifndef BARES_DAGRUNNER_H
+#define BARES_DAGRUNNER_H
+
+#include <cstddef>  // std::size_t
+#include <vector>   // std::vector
+
+#include "CompiledExpression.h"
+#include "Evaluator.h"
+#include "ExpressionDag.h"
+#include "LineReader.h"
+#include "OutputWriter.h"
+#include "Parser.h"
+
+/*!
+ * Evaluates the input in batches, sharing common subexpressions through an ExpressionDag.
+ *
+ * Each batch of `batch_lines` lines is parsed and compiled; the valid lines are added to the
+ * DAG, every distinct subexpression of the batch is evaluated once, and then the results are
+ * written in input order. The DAG is emptied between batches, so memory stays bounded.
+ */
+class DagRunner {
+    public:
+        /// Creates a runner that reads batch_lines_ lines at a time.
+        explicit DagRunner(std::size_t batch_lines_ = 65536);
+        /// Default destructor
+        ~DagRunner() = default;
+        /// Turn off copy constructor. We do not need it.
+        DagRunner(const DagRunner &) = delete;
+        /// Turn off assignment operator.
+        DagRunner &operator=(const DagRunner &) = delete;
+
+        /// Evaluates every line from reader_ and writes the results to out_.
+        void run(LineReader &reader_, OutputWriter &out_);
+
+        /// The DAG (for its statistics).
+        const ExpressionDag &dag() const { return expressions; }
+        /// Number of lines processed.
+        std::size_t lines() const { return n_lines; }
+
+    private:
+        /// Outcome of parsing one line of the batch.
+        struct Line {
+            Parser::ResultType parsed;
+            ExpressionDag::node_id root;
+        };
+
+        std::size_t batch_lines;     //!< Lines per batch.
+        Parser parser;
+        Evaluator evaluator;         //!< Used to compile each line.
+        CompiledExpression program;  //!< Postfix form of the current line.
+        ExpressionDag expressions;   //!< The DAG of the current batch.
+        std::vector<Line> batch;     //!< The lines of the current batch.
+        std::size_t n_lines = 0;
+};
+
+#endif //BARES_DAGRUNNER_H
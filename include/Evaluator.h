@@ -16,17 +16,17 @@
 #include <string>    // string
 #include <iomanip>   // std::distance
 #include <cassert>   // assert
-#include <cmath>     // pow
-#include <sstream> // std::stringstream
 #include <utility>
-#include <stack>
+#include <vector>
 
 #include "Parser.h"
+#include "CompiledExpression.h"
 
 class Evaluator {
 
-    using value_type = long int;
     public:
+        using value_type = Numeric::value_type;
+
         struct EvaluatorResult {
             enum code {
                 OK = 0,
@@ -34,30 +34,37 @@ class Evaluator {
                 NUMERIC_OVERFLOW
             };
 
-            std::string value_b;
+            value_type value_b;
             code type_b;
 
-            explicit EvaluatorResult(std::string v_ = "", code t_ = code::OK)
-                    : value_b(std::move(v_)), type_b(t_) {/* empty */}
+            explicit EvaluatorResult(value_type v_ = 0, code t_ = code::OK)
+                    : value_b(v_), type_b(t_) {/* empty */}
         };
 
     private:
-        std::vector<Token> expression;
-        bool is_operator(Token t);
-        bool is_operand(Token t);
-        bool is_opening_scope(std::string c);
-        bool is_closing_scope(std::string c);
-        bool has_higher_precedence(std::string op1, std::string op2);
-        bool is_right_association(std::string c);
-        int get_precedence(std::string c);
+        CompiledExpression expression;     //!< The postfix expression.
+        std::vector<Token, ArenaAllocator<Token>> operators;      //!< Operator stack used by infix_to_postfix().
+        std::vector<value_type, ArenaAllocator<value_type>> values; //!< Value stack used by evaluate().
+        bool is_operator(const Token &t);
+        bool is_operand(const Token &t);
+        bool is_variable(const Token &t);
+        bool is_opening_scope(const Token &t);
+        bool is_closing_scope(const Token &t);
+        bool has_higher_precedence(const Token &op1, const Token &op2);
+        bool is_right_association(const Token &t);
+        int get_precedence(const Token &t);
 
     public:
-        Evaluator() = default;
+        explicit Evaluator(Arena *arena_ = nullptr);
         ~Evaluator() = default;
         Evaluator(const Evaluator &) = delete;
         Evaluator &operator=(const Evaluator &) = delete;
-        void infix_to_postfix(std::vector<Token> infix);
-        Evaluator::EvaluatorResult execute_operator(std::string op1, std::string op2, Token opr);
-        Evaluator::EvaluatorResult evaluate(std::vector<Token>);
+        void infix_to_postfix(const Parser::token_list_type &infix);
+        void infix_to_postfix(const Parser::token_list_type &infix, CompiledExpression &postfix);
+        CompiledExpression compile(const Parser::token_list_type &infix);
+        Evaluator::EvaluatorResult execute_operator(value_type op1, value_type op2, Token::operator_t opr);
+        Evaluator::EvaluatorResult evaluate(const Parser::token_list_type &infix);
+        Evaluator::EvaluatorResult evaluate(const CompiledExpression &postfix);
+        Evaluator::EvaluatorResult evaluate(const CompiledExpression &postfix, const value_type *variables);
 };
 #endif //BARES_BARES_H
\ No newline at end of file
@@ -0,0 +1,94 @@
+#ifndef BARES_EXPRESSIONDAG_H
+#define BARES_EXPRESSIONDAG_H
+
+#include <cstddef>       // std::size_t
+#include <cstdint>       // std::uint32_t
+#include <unordered_map> // std::unordered_map
+#include <vector>        // std::vector
+
+#include "CompiledExpression.h"
+#include "Evaluator.h"
+
+/*!
+ * A hash-consed DAG of expression trees, shared by a batch of expressions.
+ *
+ * Every compiled expression added to the DAG is rebuilt as a tree whose nodes are looked up
+ * in a hash table before being created, so a subexpression that appears many times (in the
+ * same line or in different lines) becomes a single node. evaluate() then computes each node
+ * exactly once; a node whose operands or operation fail keeps the error (division by zero,
+ * overflow), which is therefore memoized as well.
+ *
+ * The result of each expression is the same as Evaluator::evaluate(): the first error found
+ * is the one of the left operand, then the right operand, then the operation itself, which
+ * is the postfix evaluation order.
+ */
+class ExpressionDag {
+    public:
+        typedef std::uint32_t node_id; //!< Identifies a node.
+
+        /// Adds the expression postfix_ and returns the id of its root node.
+        node_id add(const CompiledExpression &postfix_);
+        /// Evaluates every node added since the last call.
+        void evaluate();
+        /// The result of node id_ (valid after evaluate()).
+        const Evaluator::EvaluatorResult &result(node_id id_) const { return nodes[id_].result; }
+        /// Removes every node, keeping the allocated memory. The statistics are kept.
+        void clear();
+
+        /// Number of distinct nodes currently in the DAG.
+        std::size_t size() const { return nodes.size(); }
+        /// Number of nodes requested by add() since the DAG was created.
+        std::size_t requested() const { return n_requested; }
+        /// Number of requested nodes that were shared with an existing one.
+        std::size_t deduplicated() const { return n_requested - n_created; }
+
+        //==== Special methods
+        /// Default constructor
+        ExpressionDag() = default;
+        /// Default destructor
+        ~ExpressionDag() = default;
+        /// Turn off copy constructor. We do not need it.
+        ExpressionDag(const ExpressionDag &) = delete;
+        /// Turn off assignment operator.
+        ExpressionDag &operator=(const ExpressionDag &) = delete;
+
+    private:
+        /// A node: a constant (opcode_t::PUSH) or a binary operation over two other nodes.
+        struct Node {
+            CompiledExpression::opcode_t op;
+            Token::value_type value; //!< The constant (opcode_t::PUSH only).
+            node_id left;            //!< Left operand.
+            node_id right;           //!< Right operand.
+            Evaluator::EvaluatorResult result;
+        };
+
+        /// What makes two nodes equal.
+        struct Key {
+            CompiledExpression::opcode_t op;
+            Token::value_type value; //!< Constant value (opcode_t::PUSH only).
+            node_id a;               //!< Left operand.
+            node_id b;               //!< Right operand.
+            bool operator==(const Key &k_) const {
+                return op == k_.op and value == k_.value and a == k_.a and b == k_.b;
+            }
+        };
+        struct KeyHash {
+            std::size_t operator()(const Key &k_) const {
+                std::uint64_t h = (Numeric::fold(k_.value) ^ static_cast<std::uint64_t>(k_.a) << 32) * 0x9E3779B97F4A7C15ull;
+                h ^= (static_cast<std::uint64_t>(k_.b) << 8 | static_cast<std::uint8_t>(k_.op)) + (h << 6) + (h >> 2);
+                return static_cast<std::size_t>(h);
+            }
+        };
+
+        std::vector<Node> nodes;                         //!< Children are always created before parents.
+        std::unordered_map<Key, node_id, KeyHash> table; //!< The hash-consing table.
+        std::vector<node_id> stack;                      //!< Scratch stack used by add().
+        std::size_t n_evaluated = 0;                     //!< Nodes already evaluated.
+        std::size_t n_requested = 0;
+        std::size_t n_created = 0;
+        Evaluator evaluator;                             //!< Carries out each operation.
+
+        node_id intern(const Key &k_);
+};
+
+#endif //BARES_EXPRESSIONDAG_H
@@ -0,0 +1,79 @@
+#ifndef BARES_FUSEDEVALUATOR_H
+#define BARES_FUSEDEVALUATOR_H
+
+#include <cstddef> // std::size_t
+#include <string>  // std::string
+#include <vector>  // std::vector
+
+#include "Parser.h"
+#include "Evaluator.h"
+
+/*!
+ * Parses and evaluates an expression in a single pass.
+ *
+ * This engine follows the same grammar as Parser (see Parser.h), but instead of building
+ * a token list that the Evaluator converts to postfix and then evaluates, it keeps the pending
+ * operators and operands in two stacks and carries out each operation as soon as the precedence
+ * and associativity of the Evaluator allow, which is the order of the postfix program. Like
+ * Parser, it does not recurse, so deep nesting takes linear time and memory; the stacks are
+ * reused from one expression to the next.
+ *
+ * The results are the same as running Parser::parse() followed by Evaluator::evaluate():
+ * the same syntax error codes and columns, and, for valid expressions, the same value or
+ * the same first evaluation error (operations are carried out in postfix order).
+ */
+class FusedEvaluator {
+    public:
+        typedef Evaluator::value_type value_type;
+
+        /// Parses and evaluates e_. The evaluation result is stored in value_ if the syntax is valid.
+        Parser::ResultType evaluate(const std::string &e_, Evaluator::EvaluatorResult &value_) {
+            return evaluate(e_.data(), e_.data() + e_.size(), value_);
+        }
+        /// Parses and evaluates the expression [first_, last_), read in place.
+        Parser::ResultType evaluate(const char *first_, const char *last_, Evaluator::EvaluatorResult &value_);
+
+        /// Sets the largest number of parentheses that may be open at the same time.
+        void set_max_nesting(std::size_t max_) { max_scopes = max_; }
+        /// The largest number of parentheses that may be open at the same time.
+        std::size_t max_nesting() const { return max_scopes; }
+
+        //==== Special methods
+        /// Default constructor
+        FusedEvaluator() = default;
+        /// Default destructor
+        ~FusedEvaluator() = default;
+        /// Turn off copy constructor. We do not need it.
+        FusedEvaluator(const FusedEvaluator &) = delete;
+        /// Turn off assignment operator.
+        FusedEvaluator &operator=(const FusedEvaluator &) = delete;
+
+    private:
+        const char *first = nullptr; //!< Beginning of the expression.
+        const char *curr = nullptr;  //!< Current character.
+        const char *last = nullptr;  //!< End of the expression.
+        Evaluator::EvaluatorResult::code error = Evaluator::EvaluatorResult::OK; //!< First evaluation error.
+        Evaluator evaluator;         //!< Carries out each operation (Evaluator::execute_operator()).
+        std::vector<value_type> values;           //!< Operands not yet consumed by an operation.
+        std::vector<Token::operator_t> operators; //!< Pending operators; NONE marks an open "(".
+        std::vector<unsigned char> scopes;        //!< Open parentheses: whether each one follows an operator.
+        std::size_t max_scopes = BARES_MAX_NESTING; //!< Limit of scopes.size().
+
+    //=== Support methods.
+        bool end_input() const { return curr == last; }
+        Parser::ResultType::size_type column() const;
+        void skip_ws();
+        Token::operator_t peek_operator();
+        static int precedence(Token::operator_t op_);
+        value_type apply(Token::operator_t op_, value_type lhs_, value_type rhs_);
+        void push_operator(Token::operator_t op_);
+        void reduce();
+        Parser::ResultType failure(Parser::ResultType result_, bool after_operator_) const;
+
+    //=== NTS methods.
+        Parser::ResultType expression(value_type &value_);
+        Parser::ResultType term(value_type &value_);
+        Parser::ResultType integer(Parser::input_int_type &value_, bool &negative_);
+};
+
+#endif //BARES_FUSEDEVALUATOR_H
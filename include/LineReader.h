@@ -0,0 +1,67 @@
+#ifndef BARES_LINEREADER_H
+#define BARES_LINEREADER_H
+
+#include <string>   // std::string
+#include <vector>   // std::vector
+#include <cstddef>  // std::size_t
+
+/*!
+ * Reads an input source (regular file, named pipe or stdin) one line at a time.
+ *
+ * The reader owns a fixed-size buffer that is refilled with `read(2)`, so the
+ * memory used does not depend on the size of the input, only on the length of
+ * the longest line. Lines are handed out as soon as their terminating '\n'
+ * arrives, which lets the caller evaluate and print each expression without
+ * waiting for the rest of the input.
+ *
+ * A line is normally handed out where it lies in the buffer, without being copied; only
+ * a line longer than the whole buffer is assembled in a separate string.
+ *
+ * A regular file is not read at all: it is mapped into memory (`mmap(2)`, with the
+ * `MADV_SEQUENTIAL` hint so the kernel reads ahead and drops the pages behind), the
+ * lines are found with `memchr()` and handed out as views into the mapping, so the input
+ * is never copied. Other sources, and files that cannot be mapped, use the buffer. The
+ * file must not be truncated while it is read (that raises SIGBUS, as with any mapping).
+ */
+class LineReader {
+    public:
+        /// Default size of the read buffer, in bytes.
+        static const std::size_t default_buffer_size = 64 * 1024;
+
+        /// Reads from an already opened file descriptor (not closed by the reader).
+        explicit LineReader(int fd_, std::size_t buffer_size_ = default_buffer_size);
+        /// Unmaps the file, if it was mapped.
+        ~LineReader();
+        /// Turn off copy constructor. We do not need it.
+        LineReader(const LineReader &) = delete;
+        /// Turn off assignment operator.
+        LineReader &operator=(const LineReader &) = delete;
+
+        /// Stores the next line (without the '\n') into line_. Returns false at end of input.
+        bool next(std::string &line_);
+        /// Points [first_, last_) at the next line (without the '\n'), inside the reader's own
+        /// storage; the line stays valid until the next call. Returns false at end of input.
+        bool next(const char *&first_, const char *&last_);
+        /// Returns true if a read error happened.
+        bool failed() const { return error; }
+        /// Returns true if the source is a memory-mapped file.
+        bool mapped() const { return map_base != nullptr; }
+
+    private:
+        int fd;                  //!< Source file descriptor.
+        std::vector<char> buf;   //!< Fixed-size read buffer.
+        std::size_t pos = 0;     //!< First byte of the buffer not yet handed out.
+        std::size_t len = 0;     //!< Number of valid bytes in the buffer.
+        bool eof = false;        //!< Whether the source has been exhausted.
+        bool error = false;      //!< Whether read(2) reported an error.
+        std::string spill;       //!< A line longer than the buffer.
+        void *map_base = nullptr;       //!< Start of the mapping (page aligned), or nullptr.
+        std::size_t map_length = 0;     //!< Length of the mapping.
+        const char *map_curr = nullptr; //!< First byte of the mapped file not yet handed out.
+        const char *map_end = nullptr;  //!< End of the mapped file.
+
+        bool map();
+        bool read_more();
+};
+
+#endif //BARES_LINEREADER_H
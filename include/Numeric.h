@@ -0,0 +1,126 @@
+#ifndef BARES_NUMERIC_H
+#define BARES_NUMERIC_H
+
+#include <cstdint> // std::int16_t, std::int32_t, std::int64_t, std::uint64_t
+
+/*!
+ * Width, in bits, of the integers of an expression: 16 (the default, the original range of
+ * a `short`), 32, 64 or 128. It is chosen when the program is compiled, for example with
+ * `make INT_BITS=64` or `cmake -DBARES_INT_BITS=64`.
+ */
+#ifndef BARES_INT_BITS
+#define BARES_INT_BITS 16
+#endif
+
+/*!
+ * The integer type of the expressions and its checked arithmetic.
+ *
+ * Every operation reports whether the exact result fits in value_type (true means overflow,
+ * as the `__builtin_*_overflow` functions do). Up to 32 bits the result is computed in a
+ * type twice as wide and then compared with the limits, which the compiler can vectorize;
+ * wider types use the checked-arithmetic builtins.
+ */
+struct Numeric {
+#if BARES_INT_BITS == 16
+    typedef std::int16_t value_type;       //!< Integer of an expression.
+    typedef std::uint16_t magnitude_type;  //!< Absolute value of any value_type.
+    typedef std::int32_t wide_type;        //!< Holds the sum and the product of two value_type.
+#define BARES_HAS_WIDE_TYPE 1
+#elif BARES_INT_BITS == 32
+    typedef std::int32_t value_type;
+    typedef std::uint32_t magnitude_type;
+    typedef std::int64_t wide_type;
+#define BARES_HAS_WIDE_TYPE 1
+#elif BARES_INT_BITS == 64
+    typedef std::int64_t value_type;
+    typedef std::uint64_t magnitude_type;
+#define BARES_HAS_WIDE_TYPE 0
+#elif BARES_INT_BITS == 128
+    typedef __int128 value_type;
+    typedef unsigned __int128 magnitude_type;
+#define BARES_HAS_WIDE_TYPE 0
+#else
+#error "BARES_INT_BITS must be 16, 32, 64 or 128"
+#endif
+
+    /// Largest value_type (std::numeric_limits does not know __int128 in strict C++11).
+    static constexpr value_type max() { return static_cast<value_type>(static_cast<magnitude_type>(~magnitude_type(0)) >> 1); }
+    /// Smallest value_type.
+    static constexpr value_type min() { return static_cast<value_type>(-max() - 1); }
+
+    /// Largest magnitude of an integer with the given sign (|min()| is one more than max()).
+    static constexpr magnitude_type limit(bool negative_) {
+        return static_cast<magnitude_type>(static_cast<magnitude_type>(max()) + (negative_ ? 1 : 0));
+    }
+    /// Appends the decimal digit d_ to m_, saturating at limit(true) + 1, so that a number with too
+    /// many digits is still known to be out of range (and never wraps around).
+    static magnitude_type accumulate(magnitude_type m_, int d_) {
+        const magnitude_type cap = static_cast<magnitude_type>(limit(true) + 1);
+        if (m_ > static_cast<magnitude_type>((cap - static_cast<magnitude_type>(d_)) / 10))
+            return cap;
+        return static_cast<magnitude_type>(m_ * 10 + static_cast<magnitude_type>(d_));
+    }
+    /// The value with magnitude m_ (at most limit(negative_)) and the given sign.
+    static value_type from_magnitude(magnitude_type m_, bool negative_) {
+        return negative_ ? static_cast<value_type>(static_cast<magnitude_type>(0 - m_)) : static_cast<value_type>(m_);
+    }
+
+#if BARES_HAS_WIDE_TYPE
+    static bool add(value_type a_, value_type b_, value_type &r_) {
+        return narrow(static_cast<wide_type>(a_) + static_cast<wide_type>(b_), r_);
+    }
+    static bool sub(value_type a_, value_type b_, value_type &r_) {
+        return narrow(static_cast<wide_type>(a_) - static_cast<wide_type>(b_), r_);
+    }
+    static bool mul(value_type a_, value_type b_, value_type &r_) {
+        return narrow(static_cast<wide_type>(a_) * static_cast<wide_type>(b_), r_);
+    }
+    /// Stores w_ in r_ and tells whether it did not fit.
+    static bool narrow(wide_type w_, value_type &r_) {
+        r_ = static_cast<value_type>(w_);
+        return (w_ > max()) | (w_ < min());
+    }
+#else
+    static bool add(value_type a_, value_type b_, value_type &r_) { return __builtin_add_overflow(a_, b_, &r_); }
+    static bool sub(value_type a_, value_type b_, value_type &r_) { return __builtin_sub_overflow(a_, b_, &r_); }
+    static bool mul(value_type a_, value_type b_, value_type &r_) { return __builtin_mul_overflow(a_, b_, &r_); }
+#endif
+
+    /// Folds v_ into 64 bits, for hashing.
+    static std::uint64_t fold(value_type v_) {
+#if BARES_INT_BITS == 128
+        return static_cast<std::uint64_t>(v_) ^ static_cast<std::uint64_t>(v_ >> 64);
+#else
+        return static_cast<std::uint64_t>(v_);
+#endif
+    }
+
+    /// Computes base_ raised to exp_ by squaring, stopping as soon as the result is known to overflow.
+    /*!
+     * A negative exponent keeps the meaning it had when "^" was computed by `pow()` and truncated:
+     * 1 and -1 stay ±1, 0 overflows (1/0) and every other base gives 0.
+     */
+    static bool power(value_type base_, value_type exp_, value_type &r_) {
+        if (exp_ < 0) {
+            if (base_ == 0)
+                return true;
+            r_ = base_ == 1 ? 1 : base_ == -1 ? ((exp_ & 1) ? -1 : 1) : 0;
+            return false;
+        }
+        value_type result = 1;
+        while (true) {
+            if ((exp_ & 1) and mul(result, base_, result))
+                return true;
+            exp_ = static_cast<value_type>(exp_ >> 1);
+            if (exp_ == 0)
+                break;
+            // The square is never exactly |min()|, so if it does not fit neither does the result.
+            if (mul(base_, base_, base_))
+                return true;
+        }
+        r_ = result;
+        return false;
+    }
+};
+
+#endif //BARES_NUMERIC_H
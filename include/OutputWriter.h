@@ -0,0 +1,100 @@
+#ifndef BARES_OUTPUTWRITER_H
+#define BARES_OUTPUTWRITER_H
+
+#include <cstddef> // std::size_t
+#include <cstring> // std::strlen
+#include <vector>  // std::vector
+
+#include "Numeric.h" // BARES_INT_BITS
+
+/*!
+ * Buffered writer for the program output.
+ *
+ * Text is accumulated in a large user-space buffer and written to the file descriptor with a
+ * single `write(2)` when the buffer fills up, when flush() is called, or when the writer is
+ * destroyed. Integers are formatted by hand (two digits per step), without iostreams.
+ *
+ * In line-flush mode the buffer is also written after every end_line(), which is what an
+ * interactive user expects. A writer created without a file descriptor only accumulates
+ * text in memory (see data()/size()), e.g. to collect the output of a chunk of lines.
+ */
+class OutputWriter {
+    public:
+        /// Default size of the buffer, in bytes.
+        static const std::size_t default_capacity = 64 * 1024;
+#if BARES_INT_BITS == 128
+        typedef __int128 int_type;                    //!< Widest integer write_int() accepts.
+        typedef unsigned __int128 unsigned_int_type;
+#else
+        typedef long long int_type;                   //!< Widest integer write_int() accepts.
+        typedef unsigned long long unsigned_int_type;
+#endif
+        /// Largest number of characters write_int() produces.
+        static const std::size_t max_int_chars = 40;
+
+        /// Writes to fd_ (not closed by the writer); a negative fd_ keeps the text in memory.
+        explicit OutputWriter(int fd_ = -1, std::size_t capacity_ = default_capacity);
+        /// Flushes the buffer.
+        ~OutputWriter();
+        /// Turn off copy constructor. We do not need it.
+        OutputWriter(const OutputWriter &) = delete;
+        /// Turn off assignment operator.
+        OutputWriter &operator=(const OutputWriter &) = delete;
+
+        /// Appends n_ characters.
+        void write(const char *s_, std::size_t n_) {
+            if (n_ > buf.size() - len)
+                make_room(n_);
+            if (n_ > buf.size() - len) { // still too big: bypass the buffer.
+                write_through(s_, n_);
+                return;
+            }
+            std::memcpy(buf.data() + len, s_, n_);
+            len += n_;
+        }
+        /// Appends a null-terminated string.
+        void write(const char *s_) { write(s_, std::strlen(s_)); }
+        /// Appends a single character.
+        void put(char c_) {
+            if (len == buf.size())
+                make_room(1);
+            buf[len++] = c_;
+        }
+        /// Appends the decimal representation of v_.
+        void write_int(int_type v_);
+        /// Ends a line ('\n'), flushing it in line-flush mode.
+        void end_line() {
+            put('\n');
+            if (line_flush)
+                flush();
+        }
+
+        /// Writes the buffered text to the file descriptor.
+        void flush();
+        /// Enables or disables flushing after every line.
+        void set_line_flush(bool on_) { line_flush = on_; }
+
+        /// Text accumulated by a memory writer (or not yet flushed).
+        const char *data() const { return buf.data(); }
+        /// Number of characters in data().
+        std::size_t size() const { return len; }
+        /// Discards the buffered text.
+        void clear() { len = 0; }
+        /// Returns true if writing to the file descriptor failed.
+        bool failed() const { return error; }
+
+        /// Writes the decimal representation of v_ ending right before end_; returns where it begins.
+        static char *format_int(char *end_, int_type v_);
+
+    private:
+        int fd;                //!< Destination, or negative for a memory writer.
+        std::vector<char> buf; //!< The buffer.
+        std::size_t len = 0;   //!< Characters in the buffer.
+        bool line_flush = false;
+        bool error = false;
+
+        void make_room(std::size_t n_);
+        void write_through(const char *s_, std::size_t n_);
+};
+
+#endif //BARES_OUTPUTWRITER_H
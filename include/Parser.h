@@ -12,21 +12,39 @@
 #include <utility>
 
 #include "Token.h"  // struct Token.
+#include "Arena.h"  // ArenaAllocator
+#include "Numeric.h"
 
 /*!
- * Implements a recursive descendent parser for a EBNF grammar.
+ * Default limit of nested parentheses (see Parser::set_max_nesting()). Deeper expressions are
+ * rejected with NESTING_TOO_DEEP; the parsers use an explicit stack, so any limit is safe.
+ */
+#ifndef BARES_MAX_NESTING
+#define BARES_MAX_NESTING 10000
+#endif
+
+/*!
+ * Implements a (non-recursive) descendent parser for a EBNF grammar.
  *
  * This class also tokenizes the input expression into its components, creating a list of tokens.
  *
  * The grammar is:
  * ```
  *   <expr>            := <term>,{ ("+"|"-"),<term> };
- *   <term>            := <integer>;
+ *   <term>            := "(",<expr>,")" | <integer> | <identifier>;
  *   <integer>         := 0 | ["-"],<natural_number>;
  *   <natural_number>  := <digit_excl_zero>,{<digit>};
  *   <digit_excl_zero> := "1" | "2" | "3" | "4" | "5" | "6" | "7" | "8" | "9";
  *   <digit>           := "0"| <digit_excl_zero>;
+ *   <identifier>      := <letter>,{<letter>|<digit>};
+ *   <letter>          := "a" | ... | "z" | "A" | ... | "Z" | "_";
  * ```
+ * Identifiers (named variables) are only accepted after set_identifiers(true); by default a
+ * letter is an invalid symbol, as in the original grammar.
+ *
+ * The parser does not recurse: the open parentheses are kept in an explicit stack, so the time
+ * and memory it takes are linear in the length of the expression, however deep the nesting.
+ * More than max_nesting() open parentheses are reported as NESTING_TOO_DEEP.
  */
 
 class Parser {
@@ -45,7 +63,8 @@ class Parser {
                 MISSING_TERM,
                 EXTRANEOUS_SYMBOL,
                 MISSING_CLOSING,
-                INTEGER_OUT_OF_RANGE
+                INTEGER_OUT_OF_RANGE,
+                NESTING_TOO_DEEP
             };
 
             //=== Members (public).
@@ -58,19 +77,33 @@ class Parser {
         };
 
         //==== Aliases
-        typedef short int required_int_type;
-        typedef long long int input_int_type;
+        typedef Numeric::value_type required_int_type;   //!< Integers of the expression (see BARES_INT_BITS).
+        typedef Numeric::magnitude_type input_int_type;  //!< Absolute value of an integer while it is read.
+        typedef std::vector<Token, ArenaAllocator<Token>> token_list_type;
 
         //==== Public interface
         // Parses and tokenizes an input source expression.  Return the result as a struct.
-        ResultType parse(std::string e_);
-
-        /// Retrieves the list of tokens created during the partins process.
-        std::vector<Token> get_tokens() const;
+        ResultType parse(const std::string &e_) { return parse(e_.data(), e_.data() + e_.size()); }
+        /// Parses and tokenizes the expression [first_, last_), read in place (e.g. from an input buffer).
+        ResultType parse(const char *first_, const char *last_);
+
+        /// Retrieves (a copy of) the list of tokens created during the partins process.
+        token_list_type get_tokens() const;
+        /// The list of tokens created during the parsing process, valid until the next parse() (or arena reset).
+        const token_list_type &tokens() const { return token_list; }
+
+        /// Enables (or disables) identifiers in the grammar.
+        void set_identifiers(bool on_) { identifiers = on_; }
+        /// Sets the largest number of parentheses that may be open at the same time.
+        void set_max_nesting(std::size_t max_) { max_scopes = max_; }
+        /// The largest number of parentheses that may be open at the same time.
+        std::size_t max_nesting() const { return max_scopes; }
+        /// Names of the variables of the last expression; a token_t::VARIABLE token holds an index into it.
+        const std::vector<std::string> &variables() const { return variable_names; }
 
         //==== Special methods
-        /// Default constructor
-        Parser() = default;
+        /// Default constructor. If arena_ is given, the token list is allocated from it.
+        explicit Parser(Arena *arena_ = nullptr) : token_list(ArenaAllocator<Token>(arena_)) {/* empty */}
         /// Default destructor
         ~Parser() = default;
         /// Turn off copy constructor. We do not need it.
@@ -93,17 +126,25 @@ class Parser {
             TS_WS,              //!< code for a white-space
             TS_EOS,             //!< code for "End Of String"
             TS_TAB,             //!< code for tab
+            TS_LETTER,          //!< code for letters and "_"
             TS_INVALID,         //!< invalid token
             TS_OPENING_SCOPE,   //!< code for "("
             TS_CLOSING_SCOPE   //!< code for ")"
         };
 
         //==== Private members.
-        std::string expr;                   //!< The source expression to be parsed
-        std::string::iterator it_curr_symb; //!< Pointer to the current char inside the expression.
-        std::vector<Token> token_list;      //!< Resulting list of tokens extracted from the expression.
+        const char *expr_begin = nullptr;   //!< The source expression to be parsed (not owned).
+        const char *expr_end = nullptr;     //!< One past its last character.
+        const char *it_curr_symb = nullptr; //!< Pointer to the current char inside the expression.
+        token_list_type token_list;         //!< Resulting list of tokens extracted from the expression.
+        bool identifiers = false;           //!< Whether <identifier> is part of the grammar.
+        std::vector<std::string> variable_names; //!< Variables of the expression, in order of first use.
+        std::vector<unsigned char> scopes;  //!< Open parentheses: whether each one follows an operator.
+        std::size_t max_scopes = BARES_MAX_NESTING; //!< Limit of scopes.size().
 
         terminal_symbol_t lexer(char) const;
+        static terminal_symbol_t classify(char);
+        static Token::operator_t binary_operator(terminal_symbol_t s_);
 
     //=== Support methods.
         void next_symbol();
@@ -112,14 +153,17 @@ class Parser {
         bool expect(terminal_symbol_t);
         void skip_ws();
         bool end_input() const;
+        Token::size_type curr_col() const;
+        const char *curr_ptr() const;
 
     //=== NTS methods.
         ResultType expression();
         ResultType term();
-        ResultType integer();
-        ResultType natural_number();
+        ResultType failure(ResultType result_, bool after_operator_) const;
+        ResultType integer(input_int_type &value_, bool &negative_);
+        ResultType natural_number(input_int_type &value_);
+        Token::value_type identifier();
         bool digit_excl_zero();
-        bool digit();
 };
 
 #endif //BARES_PARSER_H
@@ -0,0 +1,80 @@
+#ifndef BARES_PIPELINERUNNER_H
+#define BARES_PIPELINERUNNER_H
+
+#include <atomic>  // std::atomic
+#include <cstddef> // std::size_t
+#include <memory>  // std::unique_ptr
+#include <string>  // std::string
+#include <vector>  // std::vector
+
+#include "OutputWriter.h"
+#include "Session.h"
+#include "SpscRing.h"
+
+/*!
+ * Evaluates the input in a pipeline of threads, so that reading, evaluating and writing
+ * overlap (`--pipeline`).
+ *
+ * A reader thread reads the input in blocks of `block_size` bytes, each one cut after its
+ * last '\n' (the rest goes to the next block), and hands the blocks to the workers in turn.
+ * Every worker evaluates the lines of its blocks in place, with its own Session, into a
+ * memory writer. A writer thread takes the blocks back in the same turn, so in input order,
+ * writes their text and returns them to the reader.
+ *
+ * The threads only meet at lock-free single-producer single-consumer rings (SpscRing):
+ * reader -> each worker, each worker -> writer, and writer -> reader for the free blocks.
+ * There are `depth` blocks per worker and no others, so memory stays bounded and a slow
+ * side (the disk, the workers or the output) holds the others back.
+ */
+class PipelineRunner {
+    public:
+        /// Default size of a block, in bytes.
+        static const std::size_t default_block_size = 256 * 1024;
+
+        /// Creates a runner with n_workers evaluating threads, each one with a session that uses the
+        /// engine e_ and a result cache of cache_size_ entries (none if 0), and depth_ blocks per worker.
+        explicit PipelineRunner(std::size_t n_workers, Session::engine_t e_ = Session::engine_t::CLASSIC,
+                                std::size_t cache_size_ = 0, std::size_t block_size_ = default_block_size,
+                                std::size_t depth_ = 4);
+        /// Default destructor
+        ~PipelineRunner() = default;
+        /// Turn off copy constructor. We do not need it.
+        PipelineRunner(const PipelineRunner &) = delete;
+        /// Turn off assignment operator.
+        PipelineRunner &operator=(const PipelineRunner &) = delete;
+
+        /// Evaluates every line read from fd_ and writes the results to out_, in input order.
+        void run(int fd_, OutputWriter &out_);
+        /// Returns true if reading the input failed.
+        bool failed() const { return error; }
+
+        /// Number of worker sessions.
+        std::size_t workers() const { return sessions.size(); }
+        /// The session used by worker i_.
+        const Session &session(std::size_t i_) const { return *sessions[i_]; }
+
+    private:
+        /// A block of whole lines and the text of their results.
+        struct Block {
+            std::vector<char> text; //!< The lines; grows when a single line does not fit.
+            std::size_t size = 0;   //!< Bytes of text in use: whole lines, each ending with '\n'.
+            OutputWriter out;       //!< Results of the lines (memory writer).
+        };
+        typedef SpscRing<Block *> ring_type; //!< A null Block marks the end of the input.
+
+        std::size_t block_size;
+        std::vector<std::unique_ptr<Block>> blocks;
+        std::vector<std::unique_ptr<Session>> sessions; //!< One session per worker.
+        std::vector<std::unique_ptr<ring_type>> to_workers; //!< Reader -> worker i.
+        std::vector<std::unique_ptr<ring_type>> to_writer;  //!< Worker i -> writer.
+        std::unique_ptr<ring_type> free_blocks;             //!< Writer -> reader.
+        std::string carry;             //!< Beginning of a line cut at the end of a block.
+        std::atomic<bool> error{false};
+
+        void read(int fd_);
+        bool fill(int fd_, Block &b_);
+        void work(std::size_t w_);
+        void write(OutputWriter &out_);
+};
+
+#endif //BARES_PIPELINERUNNER_H
@@ -0,0 +1,96 @@
+#ifndef BARES_PUSHPARSER_H
+#define BARES_PUSHPARSER_H
+
+#include <cstddef> // std::size_t
+#include <vector>  // std::vector
+
+#include "Parser.h"
+#include "Token.h"
+
+/*!
+ * Resumable form of Parser, for input that arrives in chunks (from a socket or a pipe).
+ *
+ * Every line of the input is an expression. The chunks are pushed as they come, whatever
+ * their size and wherever they are cut (in the middle of a number, between two unary minus
+ * signs, ...): between two calls the parser remembers where it is in the grammar, that is,
+ * the open parentheses, the sign given by the unary minus signs read so far and the value of
+ * the digits read so far. No byte is looked at twice, and nothing of the line is kept but
+ * its tokens.
+ *
+ * As soon as the '\n' of a line is pushed, its result is ready: the same error code, column
+ * and tokens that Parser::parse() gives for the line. Once an error is found the rest of the
+ * line is skipped without being parsed.
+ *
+ * Identifiers are not part of the grammar of this parser (see Parser::set_identifiers()).
+ */
+class PushParser {
+    public:
+        /// Tokens kept between lines; a longer line gets a new buffer, released after it.
+        static const std::size_t max_kept_tokens = 64 * 1024;
+
+        /// Parses [first_, last_) up to the end of the current line. Returns one past the last
+        /// byte consumed: the '\n' that ended a line (then ready() is true), or last_.
+        const char *push(const char *first_, const char *last_);
+        /// Ends the input: the line in progress, if any, needs no '\n'. Returns true (and
+        /// ready() becomes true) if there was one; an input ending with '\n' has none.
+        bool finish();
+        /// Discards the line in progress.
+        void clear();
+
+        /// Whether a line has ended. Its result and tokens are kept until the next push() or finish().
+        bool ready() const { return state == state_t::DONE; }
+        /// The result of the line that ended.
+        const Parser::ResultType &result() const { return outcome; }
+        /// The tokens of the line that ended (meaningful when its result is OK).
+        const Parser::token_list_type &tokens() const { return token_list; }
+        /// Number of bytes of the current line pushed so far (without the '\n').
+        std::size_t line_size() const { return offset; }
+
+        /// Sets the largest number of parentheses that may be open at the same time.
+        void set_max_nesting(std::size_t max_) { max_scopes = max_; }
+        /// The largest number of parentheses that may be open at the same time.
+        std::size_t max_nesting() const { return max_scopes; }
+
+        //==== Special methods
+        /// Default constructor
+        PushParser() = default;
+        /// Default destructor
+        ~PushParser() = default;
+        /// Turn off copy constructor. We do not need it.
+        PushParser(const PushParser &) = delete;
+        /// Turn off assignment operator.
+        PushParser &operator=(const PushParser &) = delete;
+
+    private:
+        /// Where the parser is in the grammar.
+        enum class state_t : unsigned char {
+            START,    //!< Beginning of a line: blanks before the expression.
+            TERM,     //!< A term is expected.
+            MINUS,    //!< After a unary minus: another one, or the first digit.
+            DIGITS,   //!< Inside the digits of a natural number.
+            OPERATOR, //!< After a term: an operator, a ")" or the end of the line.
+            SKIP,     //!< After an error: the rest of the line is ignored.
+            DONE      //!< The line has ended and its result is ready.
+        };
+
+        state_t state = state_t::START;
+        std::size_t offset = 0;                  //!< Bytes of the line pushed before the current chunk.
+        Parser::ResultType outcome;              //!< Result of the line (an error is known before the line ends).
+        Parser::token_list_type token_list;      //!< Tokens of the line so far.
+        std::vector<unsigned char> scopes;       //!< Open parentheses: whether each one follows an operator.
+        std::size_t scopes_after_operator = 0;   //!< How many of them follow an operator.
+        std::size_t max_scopes = BARES_MAX_NESTING; //!< Limit of scopes.size().
+        bool after_operator = false;             //!< Whether the current term follows an operator.
+        bool negative = false;                   //!< Whether the unary minus signs of the integer make it negative.
+        Parser::input_int_type value = 0;        //!< Absolute value of the digits read so far.
+        Token::size_type term_col = 0;           //!< Column where the current integer begins.
+
+        static Token::operator_t binary_operator(char c_);
+        void end_integer();
+        void end_line(Token::size_type col_);
+        void fail(Parser::ResultType::code_t code_, Token::size_type col_);
+        void open_scope(Token::size_type col_);
+        bool close_scope();
+};
+
+#endif //BARES_PUSHPARSER_H
@@ -0,0 +1,62 @@
+#ifndef BARES_RESULTCACHE_H
+#define BARES_RESULTCACHE_H
+
+#include <cstddef>       // std::size_t
+#include <list>          // std::list
+#include <unordered_map> // std::unordered_multimap
+
+#include "CompiledExpression.h"
+#include "Evaluator.h"
+
+/*!
+ * A bounded cache of evaluation results with least-recently-used eviction.
+ *
+ * Entries are keyed by the compiled (postfix) form of the expression, which is canonical with
+ * respect to white spaces and redundant parentheses, so all spellings of the same expression
+ * share one entry. Both values and evaluation errors (division by zero, overflow) are cached.
+ *
+ * A cache is not thread-safe: each Session owns its own.
+ */
+class ResultCache {
+    public:
+        /// Creates a cache that holds at most capacity_ results.
+        explicit ResultCache(std::size_t capacity_);
+        /// Default destructor
+        ~ResultCache() = default;
+        /// Turn off copy constructor. We do not need it.
+        ResultCache(const ResultCache &) = delete;
+        /// Turn off assignment operator.
+        ResultCache &operator=(const ResultCache &) = delete;
+
+        /// Looks up key_; on a hit, stores the cached result in result_ and returns true.
+        bool find(const CompiledExpression &key_, Evaluator::EvaluatorResult &result_);
+        /// Stores the result of key_, evicting the least recently used entry if the cache is full.
+        void insert(const CompiledExpression &key_, const Evaluator::EvaluatorResult &result_);
+
+        std::size_t hits() const { return n_hits; }        //!< Number of successful lookups.
+        std::size_t misses() const { return n_misses; }    //!< Number of failed lookups.
+        std::size_t evictions() const { return n_evicted; } //!< Number of entries evicted.
+        std::size_t size() const { return entries.size(); } //!< Number of cached results.
+        std::size_t capacity() const { return max_entries; } //!< Maximum number of cached results.
+
+    private:
+        /// A cached result.
+        struct Entry {
+            CompiledExpression key;
+            std::size_t hash;
+            Evaluator::EvaluatorResult result;
+        };
+        typedef std::list<Entry>::iterator entry_iterator;
+
+        std::size_t max_entries;                                     //!< Size bound.
+        std::list<Entry> entries;                                    //!< Most recently used first.
+        std::unordered_multimap<std::size_t, entry_iterator> index;  //!< Hash -> entries with that hash.
+        std::size_t n_hits = 0;
+        std::size_t n_misses = 0;
+        std::size_t n_evicted = 0;
+
+        entry_iterator lookup(const CompiledExpression &key_, std::size_t hash_);
+        void unindex(entry_iterator it_);
+};
+
+#endif //BARES_RESULTCACHE_H
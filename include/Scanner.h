@@ -0,0 +1,68 @@
+#ifndef BARES_SCANNER_H
+#define BARES_SCANNER_H
+
+#include <cstdint> // std::uint8_t
+
+/*!
+ * Fast scanning of runs of white spaces and digits.
+ *
+ * Characters are classified through a 256-entry lookup table. Long runs are skipped 16
+ * (SSE2) or 32 (AVX2) bytes at a time; the instruction set is chosen at run time from what
+ * the CPU supports, falling back to the lookup table on other machines. Every function
+ * returns a pointer to the first character that does not belong to the run, so callers
+ * keep exact column information.
+ */
+class Scanner {
+    public:
+        /// Instruction sets the scanner knows how to use.
+        enum class isa_t {
+            SCALAR = 0, //!< Lookup table only.
+            SSE2,       //!< 16 bytes at a time.
+            AVX2        //!< 32 bytes at a time.
+        };
+
+        /// Character classes stored in the lookup table (bit flags).
+        enum : std::uint8_t {
+            BLANK = 1, //!< ' ' or tab.
+            DIGIT = 2  //!< '0' to '9'.
+        };
+
+        /// Class flags of c_.
+        static std::uint8_t classify(char c_) { return table[static_cast<unsigned char>(c_)]; }
+        /// Returns true if c_ is a white space or a tab.
+        static bool is_blank(char c_) { return classify(c_) & BLANK; }
+        /// Returns true if c_ is a decimal digit.
+        static bool is_digit(char c_) { return classify(c_) & DIGIT; }
+
+        /// Returns the first character in [first_, last_) that is not a white space or a tab.
+        static const char *skip_blanks(const char *first_, const char *last_) {
+            if (first_ == last_ or not is_blank(*first_))
+                return first_; // the common case: no run at all.
+            return blanks_impl(first_ + 1, last_);
+        }
+        /// Returns the first character in [first_, last_) that is not a digit.
+        static const char *skip_digits(const char *first_, const char *last_) {
+            if (first_ == last_ or not is_digit(*first_))
+                return first_;
+            return digits_impl(first_ + 1, last_);
+        }
+
+        /// The instruction set in use.
+        static isa_t isa() { return current; }
+        /// Selects an instruction set; falls back to the best one the CPU supports if needed. Returns the one in use.
+        static isa_t set_isa(isa_t isa_);
+        /// The best instruction set supported by this CPU.
+        static isa_t best_isa();
+        /// Name of an instruction set ("scalar", "sse2", "avx2").
+        static const char *name(isa_t isa_);
+
+    private:
+        typedef const char *(*scan_fn)(const char *, const char *);
+
+        static const std::uint8_t table[256]; //!< Class flags of each character.
+        static isa_t current;                 //!< Instruction set in use.
+        static scan_fn blanks_impl;           //!< Implementation of skip_blanks() for the selected ISA.
+        static scan_fn digits_impl;           //!< Implementation of skip_digits() for the selected ISA.
+};
+
+#endif //BARES_SCANNER_H
@@ -0,0 +1,104 @@
+#ifndef BARES_SERVER_H
+#define BARES_SERVER_H
+
+#include <atomic>        // std::atomic
+#include <cstddef>       // std::size_t
+#include <cstdint>       // std::uint32_t
+#include <memory>        // std::unique_ptr
+#include <string>        // std::string
+#include <unordered_map> // std::unordered_map
+#include <vector>        // std::vector
+
+#include "OutputWriter.h"
+#include "PushParser.h"
+#include "Session.h"
+
+/*!
+ * Long-running server mode (`--serve PATH`): evaluates the lines sent by the clients of a
+ * Unix domain socket and answers each one with the same text `bares` prints for it.
+ *
+ * A client may send any number of lines, without waiting for the answers (pipelining);
+ * the answers come back in the order of the lines. When the client shuts down its side of
+ * the connection, the last line (even without a '\n') is evaluated, the pending answers are
+ * sent and the connection is closed.
+ *
+ * Every connection has its own PushParser, which parses the bytes as they are read: a line
+ * may arrive cut into any number of pieces, and its beginning is neither copied nor parsed
+ * again when the rest comes. The tokens of each line are then evaluated by the loop's
+ * Session (with the Evaluator, whatever the engine).
+ *
+ * The server runs a small, fixed number of event loops, each in its own thread with its own
+ * epoll instance and its own Session. All of them wait on the listening socket (the kernel
+ * wakes only one per new client) and a connection stays with the loop that accepted it, so
+ * nothing is shared between the threads but the counters.
+ *
+ * Answers are sent right away; what the socket does not take is kept for later, and a client
+ * whose pending answers pass `max_pending` bytes is not read from until they are sent.
+ */
+class Server {
+    public:
+        /// Pending answers, in bytes, above which a client is no longer read from.
+        static const std::size_t max_pending = 1024 * 1024;
+        /// Longest line accepted; a client sending a longer one is disconnected.
+        static const std::size_t max_line = 1024 * 1024;
+
+        /// Creates a server with n_threads event loops, each one with a session that uses
+        /// the engine e_ and a result cache of cache_size_ entries (none if 0).
+        explicit Server(std::size_t n_threads, Session::engine_t e_ = Session::engine_t::CLASSIC,
+                        std::size_t cache_size_ = 0);
+        /// Closes every socket and removes the socket file.
+        ~Server();
+        /// Turn off copy constructor. We do not need it.
+        Server(const Server &) = delete;
+        /// Turn off assignment operator.
+        Server &operator=(const Server &) = delete;
+
+        /// Creates the socket file path_ (replacing a stale one) and listens on it.
+        /// On failure returns false and describes the problem in error_.
+        bool listen(const std::string &path_, std::string &error_);
+        /// Serves the clients until stop() is called.
+        void run();
+        /// Makes run() return. It only writes to a file descriptor, so a signal handler may call it.
+        void stop();
+
+        /// Number of clients accepted so far.
+        std::size_t connections() const { return n_connections.load(); }
+        /// Number of lines evaluated so far.
+        std::size_t lines() const { return n_lines.load(); }
+
+    private:
+        /// State of one client.
+        struct Connection {
+            PushParser parser;         //!< Parses the lines as their bytes arrive.
+            std::vector<char> pending; //!< Answers the socket did not take yet.
+            std::size_t sent = 0;      //!< Bytes of pending already sent.
+            std::uint32_t events = 0;  //!< Events the loop waits for (EPOLLIN, EPOLLOUT).
+            bool eof = false;          //!< Whether the client has shut down its side.
+        };
+
+        /// One event loop and everything it owns.
+        struct Loop {
+            int epoll_fd = -1;
+            std::unique_ptr<Session> session;
+            OutputWriter text;                               //!< Answers to the last chunk read (memory writer).
+            std::vector<char> buf;                           //!< Read buffer.
+            std::unordered_map<int, Connection> clients;     //!< Connections of this loop, by descriptor.
+        };
+
+        std::string path;                            //!< Socket file, removed by the destructor.
+        int listen_fd = -1;
+        int wake_fd = -1;                            //!< eventfd written by stop().
+        std::vector<std::unique_ptr<Loop>> loops;
+        std::atomic<std::size_t> n_connections{0};
+        std::atomic<std::size_t> n_lines{0};
+
+        void serve(Loop &loop_);
+        void accept_client(Loop &loop_);
+        bool receive(Loop &loop_, int fd_, Connection &c_);
+        bool answer(Loop &loop_, int fd_, Connection &c_);
+        bool send_pending(int fd_, Connection &c_);
+        bool watch(Loop &loop_, int fd_, Connection &c_);
+        void disconnect(Loop &loop_, int fd_);
+};
+
+#endif //BARES_SERVER_H
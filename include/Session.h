@@ -0,0 +1,117 @@
+#ifndef BARES_SESSION_H
+#define BARES_SESSION_H
+
+#include <cstddef>  // std::size_t
+#include <memory>   // std::unique_ptr
+#include <string>   // std::string
+
+#include "Parser.h"
+#include "PushParser.h"
+#include "Evaluator.h"
+#include "FusedEvaluator.h"
+#include "CompiledExpression.h"
+#include "ResultCache.h"
+#include "Arena.h"
+#include "OutputWriter.h"
+#include "Stats.h"
+
+/// Text of a syntax error message: prefix, then the column, then suffix.
+struct SyntaxMessage {
+    const char *prefix;
+    const char *suffix;
+};
+/// The message for the syntax error code_ (empty for OK).
+const SyntaxMessage &syntax_message(Parser::ResultType::code_t code_);
+/// The message for the evaluation error code_ (empty for OK).
+const char *evaluation_message(Evaluator::EvaluatorResult::code code_);
+/// Prints the message for a syntax error found by the Parser.
+void print_msg(const Parser::ResultType &result, OutputWriter &out);
+/// Prints the message for an error found while evaluating the expression.
+void print_msg_bares(const Evaluator::EvaluatorResult &result, OutputWriter &out);
+/// Prints what `bares` shows for one line: the syntax error, the evaluation error or the value.
+void print_result(const Parser::ResultType &parsed, const Evaluator::EvaluatorResult &result, OutputWriter &out);
+
+/*!
+ * Runs the whole pipeline (parse, convert to postfix, evaluate) for one input line
+ * and writes the text `bares` prints for it. The line is read where it is (for example in
+ * the buffer of a LineReader); it is not copied.
+ *
+ * A session keeps its own Parser and Evaluator, so it can be reused across lines but must not be
+ * shared between threads: each worker thread owns its own session.
+ *
+ * The parser and evaluator of a session draw their memory from an Arena that is reset
+ * at the start of every line, so steady-state processing does no heap allocation.
+ *
+ * With the classic engine a session may also keep a ResultCache: each valid line is compiled
+ * into postfix and looked up before being evaluated, so repeated expressions are evaluated once.
+ *
+ * A line parsed by a PushParser arrives as tokens, so it is always evaluated by the Evaluator
+ * (and looked up in the cache), whatever the engine.
+ */
+class Session {
+    public:
+        /// Available evaluation engines.
+        enum class engine_t {
+            CLASSIC = 0, //!< Parser + Evaluator (tokens, then postfix, then evaluation).
+            FUSED        //!< FusedEvaluator: parses and evaluates in a single pass.
+        };
+
+        /// Evaluates expr_ and writes its result (or error message) to out_.
+        void run(const std::string &expr_, OutputWriter &out_) { run(expr_.data(), expr_.data() + expr_.size(), out_); }
+        /// Evaluates the expression [first_, last_), read in place, and writes its result to out_.
+        void run(const char *first_, const char *last_, OutputWriter &out_);
+        /// Evaluates expr_; result_ is only meaningful when the returned syntax result is OK.
+        Parser::ResultType evaluate(const std::string &expr_, Evaluator::EvaluatorResult &result_) {
+            return evaluate(expr_.data(), expr_.data() + expr_.size(), result_);
+        }
+        /// Evaluates the expression [first_, last_), read in place.
+        Parser::ResultType evaluate(const char *first_, const char *last_, Evaluator::EvaluatorResult &result_);
+        /// Evaluates the line that parser_ has just parsed (see PushParser::ready()) and writes its result to out_.
+        void run(const PushParser &parser_, OutputWriter &out_);
+        /// Evaluates the line that parser_ has just parsed.
+        Parser::ResultType evaluate(const PushParser &parser_, Evaluator::EvaluatorResult &result_);
+
+        //==== Special methods
+        /// Creates a session that uses the engine e_ and, if cache_size_ > 0, a result cache of that size.
+        explicit Session(engine_t e_ = engine_t::CLASSIC, std::size_t cache_size_ = 0);
+
+        /// The arena used for per-line data (for its allocation counters).
+        const Arena &arena() const { return memory; }
+        /// The result cache, or nullptr if the session does not use one.
+        const ResultCache *cache() const { return result_cache.get(); }
+        /// Sets how many parentheses may be open at the same time (see Parser::set_max_nesting()).
+        void set_max_nesting(std::size_t max_) {
+            parser.set_max_nesting(max_);
+            fused.set_max_nesting(max_);
+        }
+        /// Records the phases and the outcome of every line in stats_ (nullptr: no instrumentation).
+        /// The caller starts each line with Stats::begin_line().
+        void set_stats(Stats *stats_) { stats = stats_; }
+        /// Default destructor
+        ~Session() = default;
+        /// Turn off copy constructor. We do not need it.
+        Session(const Session &) = delete;
+        /// Turn off assignment operator.
+        Session &operator=(const Session &) = delete;
+
+    private:
+        engine_t engine;      //!< Engine used by run().
+        Arena memory;         //!< Per-line memory of the parser and the evaluator.
+        Parser parser;        //!< Parser reused across lines.
+        Evaluator evaluator;  //!< Evaluator (and its stacks) reused across lines.
+        FusedEvaluator fused; //!< Single-pass engine.
+        CompiledExpression program;                //!< Postfix form of the current line (cache key).
+        std::unique_ptr<ResultCache> result_cache; //!< Optional result cache.
+        Stats *stats = nullptr;                    //!< Optional instrumentation.
+
+        void evaluate_tokens(const Parser::token_list_type &tokens_, Evaluator::EvaluatorResult &result_);
+        void report(const Parser::ResultType &parsed_, const Evaluator::EvaluatorResult &result_, OutputWriter &out_);
+
+        /// Ends a phase of the current line (when instrumented).
+        void lap(Stats::phase_t phase_) {
+            if (BARES_STATS and stats)
+                stats->lap(phase_);
+        }
+};
+
+#endif //BARES_SESSION_H
@@ -0,0 +1,90 @@
+#ifndef BARES_SHAPERUNNER_H
+#define BARES_SHAPERUNNER_H
+
+#include <cstddef>       // std::size_t
+#include <string>        // std::string
+#include <unordered_map> // std::unordered_map
+#include <vector>        // std::vector
+
+#include "ColumnEvaluator.h"
+#include "CompiledExpression.h"
+#include "Evaluator.h"
+#include "LineReader.h"
+#include "OutputWriter.h"
+#include "Parser.h"
+
+/*!
+ * Evaluates the input in batches, grouping the lines that have the same postfix shape.
+ *
+ * Two lines have the same shape when their postfix programs have the same sequence of
+ * operations and differ only in the operands, as "1 + 2 * 3" and "40 + 5 * -6". The operands
+ * of a group are laid out column-wise and the whole group is evaluated by a ColumnEvaluator.
+ * Groups with fewer than `min_lanes` lines are not worth it and are evaluated one line at a
+ * time by the Evaluator. Results are written in input order.
+ */
+class ShapeRunner {
+    public:
+        /// Creates a runner that reads batch_lines_ lines at a time and vectorizes groups of at least min_lanes_ lines.
+        explicit ShapeRunner(std::size_t batch_lines_ = 65536, std::size_t min_lanes_ = 32);
+        /// Default destructor
+        ~ShapeRunner() = default;
+        /// Turn off copy constructor. We do not need it.
+        ShapeRunner(const ShapeRunner &) = delete;
+        /// Turn off assignment operator.
+        ShapeRunner &operator=(const ShapeRunner &) = delete;
+
+        /// Evaluates every line from reader_ and writes the results to out_.
+        void run(LineReader &reader_, OutputWriter &out_);
+
+        /// Number of lines processed.
+        std::size_t lines() const { return n_lines; }
+        /// Number of groups (distinct shapes per batch) seen.
+        std::size_t groups() const { return n_groups; }
+        /// Number of lines evaluated by the ColumnEvaluator.
+        std::size_t vectorized() const { return n_vectorized; }
+        /// Number of valid lines evaluated one at a time.
+        std::size_t scalar() const { return n_scalar; }
+
+    private:
+        typedef ColumnEvaluator::lane_type lane_type;
+
+        /// Outcome of one line of the batch.
+        struct Line {
+            Parser::ResultType parsed;
+            Evaluator::EvaluatorResult result;
+        };
+
+        /// The lines of the batch that share one shape.
+        struct Group {
+            CompiledExpression shape;        //!< Program of the group: operand k is "LOAD k".
+            std::size_t n_operands = 0;      //!< Operands per line.
+            std::vector<std::size_t> lanes;  //!< Batch index of each line.
+            std::vector<lane_type> operands; //!< Operands, one row of n_operands per line.
+        };
+
+        void add(std::size_t line_);
+        void evaluate(Group &group_);
+
+        std::size_t batch_lines;     //!< Lines per batch.
+        std::size_t min_lanes;       //!< Smallest group that is evaluated column-wise.
+        Parser parser;
+        Evaluator evaluator;
+        ColumnEvaluator columns;
+        CompiledExpression program;  //!< Postfix form of the current line.
+        std::string key;             //!< Shape of the current line: one byte per opcode.
+        std::unordered_map<std::string, std::size_t> index; //!< Shape -> group.
+        std::vector<Group> group;    //!< Groups of the current batch (the first `used` ones).
+        std::size_t used = 0;
+        std::vector<Line> batch;     //!< The lines of the current batch.
+        std::vector<lane_type> column_data;      //!< Operands of a group, column by column.
+        std::vector<const lane_type *> column_ptrs;
+        std::vector<Evaluator::value_type> row_values; //!< Operands of one line (scalar evaluation).
+        std::vector<lane_type> values;           //!< Values of the lanes of a group.
+        std::vector<ColumnEvaluator::code_type> codes; //!< Codes of the lanes of a group.
+        std::size_t n_lines = 0;
+        std::size_t n_groups = 0;
+        std::size_t n_vectorized = 0;
+        std::size_t n_scalar = 0;
+};
+
+#endif //BARES_SHAPERUNNER_H
@@ -0,0 +1,107 @@
+#ifndef BARES_SPSCRING_H
+#define BARES_SPSCRING_H
+
+#include <atomic>  // std::atomic
+#include <chrono>  // std::chrono::microseconds
+#include <cstddef> // std::size_t
+#include <thread>  // std::this_thread
+#include <vector>  // std::vector
+
+/*!
+ * Bounded lock-free queue for exactly one producer thread and one consumer thread.
+ *
+ * The slots form a ring indexed by two ever-growing counters: the producer only writes
+ * `tail` and the consumer only writes `head`, each on its own cache line, so neither side
+ * takes a lock or does a read-modify-write. Each side also keeps a private copy of the
+ * other's counter and reloads it only when the ring looks full (or empty), which keeps
+ * the cache line traffic to about one transfer per batch of operations.
+ *
+ * push() and pop() wait when the ring is full or empty: they spin for a while, then
+ * yield, then sleep for increasing periods (up to a millisecond), so an idle side costs
+ * little CPU. A full ring is what holds a fast producer back (backpressure).
+ */
+template <typename T>
+class SpscRing {
+    public:
+        /// Creates a ring with room for capacity_ values, rounded up to a power of two.
+        explicit SpscRing(std::size_t capacity_) {
+            std::size_t n = 1;
+            while (n < capacity_)
+                n *= 2;
+            slots.resize(n);
+            mask = n - 1;
+        }
+        /// Default destructor
+        ~SpscRing() = default;
+        /// Turn off copy constructor. We do not need it.
+        SpscRing(const SpscRing &) = delete;
+        /// Turn off assignment operator.
+        SpscRing &operator=(const SpscRing &) = delete;
+
+        /// Number of values the ring holds when full.
+        std::size_t capacity() const { return mask + 1; }
+
+        /// Producer: appends v_ unless the ring is full. Returns false if it is.
+        bool try_push(const T &v_) {
+            std::size_t t = tail.load(std::memory_order_relaxed);
+            if (t - head_cache > mask) {
+                head_cache = head.load(std::memory_order_acquire);
+                if (t - head_cache > mask)
+                    return false;
+            }
+            slots[t & mask] = v_;
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+        /// Consumer: removes the oldest value into v_ unless the ring is empty. Returns false if it is.
+        bool try_pop(T &v_) {
+            std::size_t h = head.load(std::memory_order_relaxed);
+            if (h == tail_cache) {
+                tail_cache = tail.load(std::memory_order_acquire);
+                if (h == tail_cache)
+                    return false;
+            }
+            v_ = slots[h & mask];
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Producer: appends v_, waiting while the ring is full.
+        void push(const T &v_) {
+            for (unsigned round = 0; not try_push(v_); ++round)
+                pause(round);
+        }
+        /// Consumer: removes the oldest value, waiting while the ring is empty.
+        T pop() {
+            T v;
+            for (unsigned round = 0; not try_pop(v); ++round)
+                pause(round);
+            return v;
+        }
+
+    private:
+        /// Keeps the counters of the two sides on different cache lines.
+        static const std::size_t cache_line = 64;
+
+        std::vector<T> slots;
+        std::size_t mask = 0;
+        char pad0[cache_line];
+        std::atomic<std::size_t> head{0}; //!< Next slot to pop (written by the consumer).
+        std::size_t tail_cache = 0;       //!< The consumer's copy of tail.
+        char pad1[cache_line];
+        std::atomic<std::size_t> tail{0}; //!< Next slot to push (written by the producer).
+        std::size_t head_cache = 0;       //!< The producer's copy of head.
+        char pad2[cache_line];
+
+        /// Waits a little longer at every round_.
+        static void pause(unsigned round_) {
+            if (round_ < 64)
+                return;
+            if (round_ < 128)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(round_ < 138 ? 1u << (round_ - 128) : 1000u));
+        }
+};
+
+#endif //BARES_SPSCRING_H
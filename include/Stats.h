@@ -0,0 +1,102 @@
+#ifndef BARES_STATS_H
+#define BARES_STATS_H
+
+#include <cstddef> // std::size_t
+#include <cstdint> // std::uint64_t
+#include <ostream> // std::ostream
+#include <utility> // std::pair
+#include <vector>  // std::vector
+
+#include "Evaluator.h"
+#include "Parser.h"
+
+/*!
+ * Set BARES_STATS to 0 (`make STATS=0`, `cmake -DBARES_STATS=OFF`) to compile the
+ * instrumentation out: every call site tests it as a constant, so nothing is left of them.
+ */
+#ifndef BARES_STATS
+#define BARES_STATS 1
+#endif
+
+class Arena;
+class ResultCache;
+
+/*!
+ * Instrumentation of the line-at-a-time mode (`--stats`).
+ *
+ * For each line the caller calls begin_line(), then lap() at the end of every phase (the time
+ * since the previous lap goes to that phase), then end_line() with the outcome. Stats keeps
+ * the cumulative time of each phase, a histogram of the line latencies, the number of lines
+ * per result code and the slowest lines.
+ *
+ * The histogram has 8 buckets per power of two, so a percentile is known within 12.5%.
+ */
+class Stats {
+    public:
+        /// Phases of a line.
+        enum class phase_t {
+            READ = 0, //!< Reading the line (LineReader::next()).
+            PARSE,    //!< Parser::parse().
+            POSTFIX,  //!< Evaluator::infix_to_postfix().
+            EVALUATE, //!< Evaluator::evaluate() (and the result cache, if any).
+            FUSED,    //!< FusedEvaluator::evaluate(): parsing and evaluation together.
+            OUTPUT    //!< Formatting the result.
+        };
+        static const std::size_t n_phases = 6;
+
+        typedef std::uint64_t nanoseconds;
+
+        /// Creates an empty set of statistics that remembers the slowest_ slowest lines.
+        explicit Stats(std::size_t slowest_ = 10);
+        /// Default destructor
+        ~Stats() = default;
+        /// Turn off copy constructor. We do not need it.
+        Stats(const Stats &) = delete;
+        /// Turn off assignment operator.
+        Stats &operator=(const Stats &) = delete;
+
+        /// Starts timing a new line.
+        void begin_line() { start = last = now(); }
+        /// Adds the time since the previous lap to phase_.
+        void lap(phase_t phase_) {
+            nanoseconds t = now();
+            phase_ns[static_cast<std::size_t>(phase_)] += t - last;
+            last = t;
+        }
+        /// Records the outcome of the line and its latency (from begin_line() to the last lap()).
+        void end_line(const Parser::ResultType &parsed_, const Evaluator::EvaluatorResult &result_);
+
+        /// Number of lines recorded.
+        std::size_t lines() const { return n_lines; }
+        /// Latency, in nanoseconds, below which fraction_ of the lines are (0.5 gives the median).
+        nanoseconds percentile(double fraction_) const;
+
+        /// Writes the statistics as "key=value" text; arena_ and cache_ are optional.
+        void print_text(std::ostream &os_, const Arena *arena_, const ResultCache *cache_) const;
+        /// Writes the statistics as a JSON object; arena_ and cache_ are optional.
+        void print_json(std::ostream &os_, const Arena *arena_, const ResultCache *cache_) const;
+
+    private:
+        static const int sub_buckets = 8;       //!< Buckets per power of two.
+        static const int n_buckets = 64 * sub_buckets;
+
+        nanoseconds start = 0;                  //!< Start of the current line.
+        nanoseconds last = 0;                   //!< Last lap of the current line.
+        nanoseconds phase_ns[n_phases] = {};    //!< Cumulative time of each phase.
+        std::size_t n_lines = 0;
+        nanoseconds total_ns = 0;               //!< Sum of the latencies.
+        nanoseconds max_ns = 0;                 //!< Largest latency.
+        std::vector<std::size_t> histogram;     //!< Lines per latency bucket.
+        static const std::size_t n_parse_codes = Parser::ResultType::NESTING_TOO_DEEP + 1;
+        static const std::size_t n_eval_codes = Evaluator::EvaluatorResult::NUMERIC_OVERFLOW + 1;
+        std::size_t parse_codes[n_parse_codes] = {}; //!< Lines per Parser::ResultType::code_t.
+        std::size_t eval_codes[n_eval_codes] = {};   //!< Valid lines per Evaluator::EvaluatorResult::code.
+        std::size_t n_slowest;                  //!< How many of the slowest lines are kept.
+        std::vector<std::pair<nanoseconds, std::size_t>> slowest; //!< (latency, line number), a min-heap.
+
+        static nanoseconds now();
+        static int bucket(nanoseconds ns_);
+        static nanoseconds bucket_limit(int bucket_);
+};
+
+#endif //BARES_STATS_H
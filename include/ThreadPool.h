@@ -0,0 +1,68 @@
+#ifndef BARES_THREADPOOL_H
+#define BARES_THREADPOOL_H
+
+#include <atomic>             // std::atomic
+#include <condition_variable> // std::condition_variable
+#include <cstddef>            // std::size_t
+#include <deque>              // std::deque
+#include <functional>         // std::function
+#include <memory>             // std::unique_ptr
+#include <mutex>              // std::mutex
+#include <thread>             // std::thread
+#include <vector>             // std::vector
+
+/*!
+ * A fixed-size pool of worker threads with work stealing.
+ *
+ * Every worker owns a deque of tasks. submit() distributes tasks round-robin; a worker
+ * takes work from the back of its own deque and, when it runs dry, steals from the
+ * front of another worker's deque. A worker stuck on an expensive task therefore does
+ * not hold back the tasks that were queued behind it.
+ *
+ * Tasks receive the index of the worker running them, so they can use per-worker state
+ * (e.g. one Session per thread) without locking.
+ */
+class ThreadPool {
+    public:
+        /// A task; the argument is the index (0 .. size()-1) of the worker running it.
+        typedef std::function<void(std::size_t)> task_type;
+
+        /// Starts n_workers threads (at least one).
+        explicit ThreadPool(std::size_t n_workers);
+        /// Waits for the pending tasks and joins the workers.
+        ~ThreadPool();
+        /// Turn off copy constructor. We do not need it.
+        ThreadPool(const ThreadPool &) = delete;
+        /// Turn off assignment operator.
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        /// Queues a task for execution.
+        void submit(task_type task_);
+        /// Blocks until every submitted task has finished.
+        void wait();
+        /// Number of worker threads.
+        std::size_t size() const { return workers.size(); }
+
+    private:
+        /// Per-worker task queue.
+        struct Queue {
+            std::mutex mtx;
+            std::deque<task_type> tasks;
+        };
+
+        std::vector<std::thread> workers;            //!< The worker threads.
+        std::vector<std::unique_ptr<Queue>> queues;  //!< One queue per worker.
+        std::atomic<std::size_t> next_queue{0};      //!< Round-robin cursor used by submit().
+        std::atomic<std::size_t> queued{0};          //!< Tasks waiting in some queue.
+
+        std::mutex state_mtx;                        //!< Protects the fields below.
+        std::condition_variable work_cv;             //!< Signals new work (or shutdown).
+        std::condition_variable done_cv;             //!< Signals that pending reached zero.
+        std::size_t pending = 0;                     //!< Tasks submitted but not yet finished.
+        bool stopping = false;                       //!< Set by the destructor.
+
+        bool try_pop(std::size_t self_, task_type &task_);
+        void worker_loop(std::size_t self_);
+};
+
+#endif //BARES_THREADPOOL_H
@@ -1,31 +1,81 @@
 #ifndef BARES_TOKEN_H
 #define BARES_TOKEN_H
 
-#include <string>   // std::string
+#include <cstdint>  // std::uint32_t, std::uint8_t
 #include <iostream> // std::ostream
 
+#include "Numeric.h"      // Numeric::value_type
+#include "OutputWriter.h" // OutputWriter::format_int
+
 /// Represents a token.
+/*!
+ * Tokens are small plain values (12 bytes with 16-bit integers): an operand carries its integer value,
+ * an operator carries its code, and every token remembers the column where it begins.
+ * Creating a token never allocates memory.
+ */
 struct Token {
 public:
-    enum class token_t : int {
+    enum class token_t : std::uint8_t {
         OPERAND = 0,   //!< A type representing numbers.
         OPERATOR,      //!< A type representing  "+", "-". "*", "/", "%", "^".
         OPENING_SCOPE, //!< A type representing "(".
-        CLOSING_SCOPE  //!< A type representing ")".
+        CLOSING_SCOPE, //!< A type representing ")".
+        VARIABLE       //!< A type representing a named variable (its value is the variable index).
+    };
+
+    /// The operator carried by an token_t::OPERATOR token.
+    enum class operator_t : std::uint8_t {
+        NONE = 0,   //!< Not an operator.
+        PLUS,       //!< "+"
+        MINUS,      //!< "-"
+        TIMES,      //!< "*"
+        SLASH,      //!< "/"
+        MOD,        //!< "%"
+        CIRCUMFLEX  //!< "^"
     };
 
-    std::string value; //!< The token value as a string.
-    token_t type;      //!< The token type, which is either token_t::OPERAND or token_t::OPERATOR.
+    typedef Numeric::value_type value_type; //!< Operand payload.
+    typedef std::uint32_t size_type; //!< Used for column location.
+
+    value_type value; //!< The operand value (token_t::OPERAND) or variable index (token_t::VARIABLE).
+    size_type col;    //!< Column (starting at 1) where the token begins in the expression.
+    token_t type;     //!< The token type.
+    operator_t op;    //!< The operator code (token_t::OPERATOR only).
 
     /// Construtor default.
-    explicit Token(std::string v_ = "", token_t t_ = token_t::OPERAND)
-            : value(std::move(v_)), type(t_) {/* empty */}
+    explicit Token(token_t t_ = token_t::OPERAND, operator_t op_ = operator_t::NONE,
+                   value_type v_ = 0, size_type col_ = 0)
+            : value(v_), col(col_), type(t_), op(op_) {/* empty */}
+
+    /// Returns the character that represents an operator or a scope token.
+    char symbol() const {
+        static const char operators[] = {'?', '+', '-', '*', '/', '%', '^'};
+        switch (type) {
+            case token_t::OPENING_SCOPE:
+                return '(';
+            case token_t::CLOSING_SCOPE:
+                return ')';
+            case token_t::OPERATOR:
+                return operators[static_cast<int>(op)];
+            default:
+                return '?';
+        }
+    }
 
     /// Just to help us debug the code.
     friend std::ostream &operator<<(std::ostream &os_, const Token &t_) {
-        std::string types[] = {"OPERAND", "OPERATOR", "CLOSING SCOPE", "OPENING SCOPE"};
+        static const char *types[] = {"OPERAND", "OPERATOR", "OPENING SCOPE", "CLOSING SCOPE", "VARIABLE"};
 
-        os_ << "<" << t_.value << "," << types[(int) (t_.type)] << ">";
+        os_ << "<";
+        if (t_.type == token_t::OPERAND or t_.type == token_t::VARIABLE) {
+            char digits[OutputWriter::max_int_chars];
+            char *end = digits + OutputWriter::max_int_chars;
+            char *begin = OutputWriter::format_int(end, t_.value);
+            os_.write(begin, end - begin);
+        }
+        else
+            os_ << t_.symbol();
+        os_ << "," << types[static_cast<int>(t_.type)] << "," << t_.col << ">";
 
         return os_;
     }
@@ -0,0 +1,105 @@
+#ifndef BARES_H
+#define BARES_H
+
+/*!
+ * C interface of libbares: evaluates arithmetic expressions in-process, with the same
+ * grammar, results and messages as the `bares` program.
+ *
+ * All the work is done through a context. A context owns every buffer it needs and reuses
+ * them, so once it has seen expressions as long as the ones it gets, evaluating does not
+ * allocate memory (except to store new entries when the context has a result cache). A context must not be used by two threads at the same time; distinct
+ * contexts share nothing and can be used in parallel, one per thread.
+ *
+ * No function throws or aborts: a context that cannot be created is returned as NULL.
+ */
+
+#include <stddef.h> /* size_t */
+#include <stdint.h> /* int32_t, int64_t, uint32_t */
+
+#if defined(__GNUC__)
+#define BARES_API __attribute__((visibility("default")))
+#else
+#define BARES_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*! Outcome of an expression. The syntax errors come first, in the order the parser checks them. */
+typedef enum bares_status {
+    BARES_OK = 0,
+    BARES_UNEXPECTED_END_OF_EXPRESSION = 1,
+    BARES_ILL_FORMED_INTEGER = 2,
+    BARES_MISSING_TERM = 3,
+    BARES_EXTRANEOUS_SYMBOL = 4,
+    BARES_MISSING_CLOSING = 5,
+    BARES_INTEGER_OUT_OF_RANGE = 6,
+    BARES_DIVISION_BY_ZERO = 7,
+    BARES_NUMERIC_OVERFLOW = 8,
+    BARES_OUT_OF_MEMORY = 9, /*!< The context could not grow its buffers for this expression. */
+    BARES_NESTING_TOO_DEEP = 10 /*!< More parentheses open at once than the context allows. */
+} bares_status;
+
+/*! Evaluation engine of a context (see `bares --engine`). */
+typedef enum bares_engine {
+    BARES_ENGINE_CLASSIC = 0, /*!< Tokens, then postfix, then evaluation. */
+    BARES_ENGINE_FUSED = 1    /*!< Parses and evaluates in a single pass. */
+} bares_engine;
+
+/*! An expression: size bytes starting at data (no terminating '\0' needed). */
+typedef struct bares_string {
+    const char *data;
+    size_t size;
+} bares_string;
+
+/*! Result of one expression. */
+typedef struct bares_result {
+    int32_t status;     /*!< A bares_status. */
+    uint32_t column;    /*!< Column (from 1) of a syntax error; 0 otherwise. */
+    int64_t value;      /*!< The value, when status is BARES_OK (its low 64 bits with 128-bit integers). */
+    int64_t value_high; /*!< High 64 bits of the value with 128-bit integers; otherwise the sign of value. */
+} bares_result;
+
+typedef struct bares_context bares_context;
+
+/*! Width, in bits, of the integers of the expressions (16, 32, 64 or 128; chosen at build time). */
+BARES_API int bares_int_bits(void);
+
+/*!
+ * Creates a context.
+ *
+ * \param engine The evaluation engine.
+ * \param cache_size Results remembered for repeated expressions (classic engine only; 0 for none).
+ * \return The context, or NULL if it could not be created.
+ */
+BARES_API bares_context *bares_context_new(bares_engine engine, size_t cache_size);
+/*! Destroys a context (NULL is ignored). */
+BARES_API void bares_context_free(bares_context *ctx);
+
+/*! Sets how many parentheses may be open at the same time (the default is BARES_MAX_NESTING, 10000). */
+BARES_API void bares_set_max_nesting(bares_context *ctx, size_t max_nesting);
+
+/*! Evaluates the expression [data, data + size) into *result; returns result->status. */
+BARES_API bares_status bares_eval(bares_context *ctx, const char *data, size_t size, bares_result *result);
+
+/*!
+ * Evaluates count expressions, storing the result of exprs[i] in results[i].
+ *
+ * \return How many of them have status BARES_OK.
+ */
+BARES_API size_t bares_eval_batch(bares_context *ctx, const bares_string *exprs, size_t count, bares_result *results);
+
+/*!
+ * Writes the text `bares` prints for a result (the value or the message, without the line
+ * break) into buf, truncated to size - 1 characters and always terminated by '\0' if size > 0.
+ *
+ * \return The length of the whole text, as snprintf() does.
+ */
+BARES_API size_t bares_format(const bares_result *result, char *buf, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BARES_H */
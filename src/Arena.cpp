@@ -0,0 +1,72 @@
+#include "Arena.h"
+
+#include <cstdint> // std::uintptr_t
+#include <cstdlib> // std::malloc, std::free
+#include <new>     // std::bad_alloc
+
+Arena::Arena(std::size_t block_size_) : block_size(block_size_ > 0 ? block_size_ : default_block_size) {/* empty */}
+
+Arena::~Arena() {
+    for (Block &b : blocks)
+        std::free(b.data);
+}
+
+/*!
+ * Allocates memory from the arena.
+ *
+ * The request is served from the current block; when it does not fit, the next block
+ * (kept from before a reset()) is used, or a new block is requested from the system.
+ *
+ * \param n_ Number of bytes.
+ * \param align_ Required alignment (a power of two).
+ * \return Pointer to the memory, valid until the next reset().
+ */
+void *Arena::allocate(std::size_t n_, std::size_t align_) {
+    ++n_allocations;
+    for (; curr < blocks.size(); ++curr, offset = 0) {
+        Block &b = blocks[curr];
+        std::size_t start = aligned(b, align_);
+        if (start + n_ <= b.size) {
+            offset = start + n_;
+            return b.data + start;
+        }
+    }
+
+    std::size_t size = (n_ + align_ > block_size) ? n_ + align_ : block_size;
+    auto *data = static_cast<char *>(std::malloc(size));
+    if (data == nullptr)
+        throw std::bad_alloc();
+    blocks.push_back(Block{data, size});
+    curr = blocks.size() - 1;
+    std::size_t start = aligned(blocks.back(), align_);
+    offset = start + n_;
+    return data + start;
+}
+
+/// First offset in b_, at or after the current offset, aligned to align_.
+std::size_t Arena::aligned(const Block &b_, std::size_t align_) const {
+    auto base = reinterpret_cast<std::uintptr_t>(b_.data);
+    auto mask = static_cast<std::uintptr_t>(align_) - 1;
+    return static_cast<std::size_t>(((base + offset + mask) & ~mask) - base);
+}
+
+//!< Libera toda a memória de uma vez, mantendo os blocos para o próximo uso
+void Arena::reset() {
+    curr = 0;
+    offset = 0;
+    ++n_resets;
+}
+
+std::size_t Arena::bytes_in_use() const {
+    std::size_t total = offset;
+    for (std::size_t i = 0; i < curr and i < blocks.size(); ++i)
+        total += blocks[i].size;
+    return total;
+}
+
+std::size_t Arena::capacity() const {
+    std::size_t total = 0;
+    for (const Block &b : blocks)
+        total += b.size;
+    return total;
+}
@@ -0,0 +1,62 @@
+#include "BatchRunner.h"
+
+#include <algorithm> // std::min
+
+BatchRunner::BatchRunner(std::size_t n_jobs, Session::engine_t e_, std::size_t cache_size_,
+                         std::size_t batch_lines_, std::size_t grain_)
+        : batch_lines(batch_lines_ > 0 ? batch_lines_ : 1), grain(grain_ > 0 ? grain_ : 1), pool(n_jobs) {
+    for (std::size_t i = 0; i < pool.size(); ++i)
+        sessions.emplace_back(new Session(e_, cache_size_));
+}
+
+//!< Lê o próximo lote de linhas, reaproveitando as strings do lote anterior
+void BatchRunner::read_batch(LineReader &reader_, Batch &b_) {
+    if (b_.lines.size() < batch_lines)
+        b_.lines.resize(batch_lines);
+    b_.size = 0;
+    while (b_.size < batch_lines and reader_.next(b_.lines[b_.size]))
+        ++b_.size;
+}
+
+//!< Divide o lote em pedaços e entrega cada um ao pool
+void BatchRunner::dispatch(Batch &b_) {
+    std::size_t n_chunks = (b_.size + grain - 1) / grain;
+    while (b_.output.size() < n_chunks)
+        b_.output.emplace_back(new OutputWriter);
+
+    for (std::size_t c = 0; c < n_chunks; ++c) {
+        Batch *batch = &b_;
+        std::size_t first = c * grain;
+        std::size_t last = std::min(first + grain, b_.size);
+        pool.submit([this, batch, c, first, last](std::size_t worker) {
+            OutputWriter &out = *batch->output[c];
+            Session &session = *sessions[worker];
+            out.clear();
+            for (std::size_t i = first; i < last; ++i)
+                session.run(batch->lines[i], out);
+        });
+    }
+}
+
+/*!
+ * Evaluates every line of the input.
+ *
+ * \param reader_ The input source.
+ * \param out_ Where the results are written, in the same order as the input lines.
+ */
+void BatchRunner::run(LineReader &reader_, OutputWriter &out_) {
+    Batch batches[2];
+    std::size_t curr = 0;
+
+    read_batch(reader_, batches[curr]);
+    while (batches[curr].size > 0) {
+        dispatch(batches[curr]);
+        read_batch(reader_, batches[1 - curr]); // overlaps with the evaluation.
+        pool.wait();
+
+        std::size_t n_chunks = (batches[curr].size + grain - 1) / grain;
+        for (std::size_t c = 0; c < n_chunks; ++c)
+            out_.write(batches[curr].output[c]->data(), batches[curr].output[c]->size());
+        curr = 1 - curr;
+    }
+}
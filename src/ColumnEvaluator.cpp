@@ -0,0 +1,125 @@
+#include "ColumnEvaluator.h"
+
+#include <cassert> // assert
+#include <cstring> // std::memcpy
+
+// Builds AVX2 and generic versions of the kernels; the loader picks one for the running CPU.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define BARES_KERNEL __attribute__((target_clones("avx2", "default")))
+#else
+#define BARES_KERNEL
+#endif
+
+namespace {
+
+typedef ColumnEvaluator::lane_type lane_type;
+typedef ColumnEvaluator::code_type code_type;
+
+const code_type code_ok = Evaluator::EvaluatorResult::OK;
+const code_type code_overflow = Evaluator::EvaluatorResult::NUMERIC_OVERFLOW;
+
+/*
+ * The kernels below compute the operation on every lane, error or not, without branches:
+ * a lane keeps its first error code and continues with 0 after an overflow, so the values
+ * of lanes in error never grow. Both are done with masks, which the vectorizer accepts.
+ * The output column never overlaps the input columns (see ColumnEvaluator::evaluate()).
+ */
+
+/// Records an overflow in code_ (unless it already holds an error) and returns r_, or 0 on overflow.
+inline lane_type settle(bool overflow_, lane_type r_, code_type &code_) {
+    code_ |= static_cast<code_type>(code_overflow * overflow_) & static_cast<code_type>(-(code_ == 0));
+    return static_cast<lane_type>(r_ & static_cast<lane_type>(overflow_ - 1));
+}
+
+BARES_KERNEL
+void add_kernel(const lane_type *__restrict a_, const lane_type *__restrict b_, lane_type *__restrict out_,
+                code_type *__restrict codes_, std::size_t n_) {
+    for (std::size_t i = 0; i < n_; ++i) {
+        lane_type r;
+        bool ovf = Numeric::add(a_[i], b_[i], r);
+        out_[i] = settle(ovf, r, codes_[i]);
+    }
+}
+
+BARES_KERNEL
+void sub_kernel(const lane_type *__restrict a_, const lane_type *__restrict b_, lane_type *__restrict out_,
+                code_type *__restrict codes_, std::size_t n_) {
+    for (std::size_t i = 0; i < n_; ++i) {
+        lane_type r;
+        bool ovf = Numeric::sub(a_[i], b_[i], r);
+        out_[i] = settle(ovf, r, codes_[i]);
+    }
+}
+
+BARES_KERNEL
+void mul_kernel(const lane_type *__restrict a_, const lane_type *__restrict b_, lane_type *__restrict out_,
+                code_type *__restrict codes_, std::size_t n_) {
+    for (std::size_t i = 0; i < n_; ++i) {
+        lane_type r;
+        bool ovf = Numeric::mul(a_[i], b_[i], r);
+        out_[i] = settle(ovf, r, codes_[i]);
+    }
+}
+
+} // namespace
+
+//!< Aplica, lane a lane, uma operação sem kernel vetorial
+void ColumnEvaluator::scalar_kernel(Token::operator_t op_, const lane_type *a_, const lane_type *b_, lane_type *out_,
+                                    code_type *codes_, std::size_t n_) {
+    for (std::size_t i = 0; i < n_; ++i) {
+        auto r = evaluator.execute_operator(a_[i], b_[i], op_);
+        if (codes_[i] == code_ok)
+            codes_[i] = static_cast<code_type>(r.type_b);
+        out_[i] = r.type_b == Evaluator::EvaluatorResult::OK ? static_cast<lane_type>(r.value_b) : 0;
+    }
+}
+
+void ColumnEvaluator::evaluate(const CompiledExpression &shape_, const lane_type *const *columns_, std::size_t lanes_,
+                               lane_type *values_, code_type *codes_) {
+    std::size_t depth = shape_.max_stack_depth();
+    if (buffers.size() < 2 * depth * lanes_)
+        buffers.resize(2 * depth * lanes_);
+    slots.resize(depth);
+    for (std::size_t i = 0; i < lanes_; ++i)
+        codes_[i] = code_ok;
+
+    std::size_t top = 0; // número de colunas na pilha
+    for (const CompiledExpression::Instruction &ins : shape_) {
+        if (ins.op == CompiledExpression::opcode_t::LOAD) {
+            slots[top++] = columns_[ins.operand]; // no copy: the slot just refers to the column.
+            continue;
+        }
+        if (ins.op == CompiledExpression::opcode_t::PUSH) {
+            lane_type *constant = buffers.data() + 2 * top * lanes_;
+            for (std::size_t i = 0; i < lanes_; ++i)
+                constant[i] = ins.operand;
+            slots[top++] = constant;
+            continue;
+        }
+        assert(top >= 2);
+        const lane_type *a = slots[top - 2];
+        const lane_type *b = slots[top - 1];
+        // Each stack slot has two buffers, used in turns, so that the result never overwrites an operand.
+        lane_type *out = buffers.data() + 2 * (top - 2) * lanes_;
+        if (out == a)
+            out += lanes_;
+        switch (ins.op) {
+            case CompiledExpression::opcode_t::ADD:
+                add_kernel(a, b, out, codes_, lanes_);
+                break;
+            case CompiledExpression::opcode_t::SUB:
+                sub_kernel(a, b, out, codes_, lanes_);
+                break;
+            case CompiledExpression::opcode_t::MUL:
+                mul_kernel(a, b, out, codes_, lanes_);
+                break;
+            default:
+                scalar_kernel(CompiledExpression::operator_of(ins.op), a, b, out, codes_, lanes_);
+                break;
+        }
+        slots[--top - 1] = out;
+    }
+
+    assert(top == 1);
+    std::memcpy(values_, slots[0], lanes_ * sizeof(lane_type));
+}
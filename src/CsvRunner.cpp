@@ -0,0 +1,127 @@
+#include "CsvRunner.h"
+
+#include "Scanner.h"
+#include "Session.h" // print_result
+
+CsvRunner::CsvRunner(const CompiledExpression &program_, const std::vector<std::string> &variables_,
+                     std::size_t block_rows_)
+    : program(program_), names(variables_), block_rows(block_rows_ > 0 ? block_rows_ : 1) {
+    column_data.resize(names.size() * block_rows);
+    for (std::size_t v = 0; v < names.size(); ++v)
+        column_ptrs.push_back(column_data.data() + v * block_rows);
+    parsed.resize(block_rows);
+    values.resize(block_rows);
+    codes.resize(block_rows);
+}
+
+bool CsvRunner::open(LineReader &reader_, std::string &missing_) {
+    std::string header;
+    if (not reader_.next(header))
+        header.clear();
+
+    // Splits the header at the commas, ignoring the blanks around each name.
+    std::vector<std::string> fields;
+    const char *p = header.data();
+    const char *end = p + header.size();
+    while (true) {
+        const char *first = Scanner::skip_blanks(p, end);
+        const char *comma = first;
+        while (comma != end and *comma != ',')
+            ++comma;
+        const char *last = comma;
+        while (last != first and Scanner::is_blank(last[-1]))
+            --last;
+        fields.emplace_back(first, last);
+        if (comma == end)
+            break;
+        p = comma + 1;
+    }
+
+    field_variable.assign(fields.size(), -1);
+    for (std::size_t v = 0; v < names.size(); ++v) {
+        std::size_t f = 0;
+        while (f < fields.size() and fields[f] != names[v])
+            ++f;
+        if (f == fields.size()) {
+            missing_ = names[v];
+            return false;
+        }
+        field_variable[f] = static_cast<int>(v);
+    }
+    return true;
+}
+
+//!< Lê os campos de uma linha do CSV para a posição lane_ das colunas
+Parser::ResultType CsvRunner::read_row(const std::string &row_, std::size_t lane_) {
+    const char *begin = row_.data();
+    const char *end = begin + row_.size();
+    const char *p = begin;
+    std::size_t found = 0;
+
+    for (std::size_t f = 0; f < field_variable.size() and found < names.size(); ++f) {
+        if (f > 0) {
+            while (p != end and *p != ',')
+                ++p;
+            if (p == end)
+                break;
+            ++p;
+        }
+        if (field_variable[f] < 0)
+            continue;
+
+        // <integer> := ["-"],<digit>,{<digit>}, between blanks.
+        p = Scanner::skip_blanks(p, end);
+        const char *start = p;
+        bool negative = p != end and *p == '-';
+        if (negative)
+            ++p;
+        const char *last = Scanner::skip_digits(p, end);
+        if (last == p)
+            return Parser::ResultType(Parser::ResultType::ILL_FORMED_INTEGER, static_cast<std::size_t>(p - begin) + 1);
+        Numeric::magnitude_type value = 0;
+        for (; p != last; ++p)
+            value = Numeric::accumulate(value, *p - '0');
+        if (value > Numeric::limit(negative))
+            return Parser::ResultType(Parser::ResultType::INTEGER_OUT_OF_RANGE,
+                                      static_cast<std::size_t>(start - begin) + 1);
+        p = Scanner::skip_blanks(p, end);
+        if (p != end and *p != ',')
+            return Parser::ResultType(Parser::ResultType::EXTRANEOUS_SYMBOL, static_cast<std::size_t>(p - begin) + 1);
+
+        column_data[static_cast<std::size_t>(field_variable[f]) * block_rows + lane_] = Numeric::from_magnitude(value, negative);
+        ++found;
+    }
+
+    if (found < names.size())
+        return Parser::ResultType(Parser::ResultType::MISSING_TERM, row_.size() + 1);
+    return Parser::ResultType(Parser::ResultType::OK);
+}
+
+/*!
+ * Evaluates every row of the input.
+ *
+ * \param reader_ The input source, just after the header.
+ * \param out_ Where the results are written, in the same order as the rows.
+ */
+void CsvRunner::run(LineReader &reader_, OutputWriter &out_) {
+    bool more = true;
+    while (more) {
+        std::size_t n = 0;
+        while (n < block_rows and (more = reader_.next(row))) {
+            parsed[n] = read_row(row, n);
+            if (parsed[n].type != Parser::ResultType::OK)
+                for (std::size_t v = 0; v < names.size(); ++v)
+                    column_data[v * block_rows + n] = 0; // the lane is evaluated anyway, but never shown.
+            ++n;
+        }
+        if (n == 0)
+            break;
+        n_rows += n;
+
+        columns.evaluate(program, column_ptrs.data(), n, values.data(), codes.data());
+
+        for (std::size_t i = 0; i < n; ++i)
+            print_result(parsed[i], Evaluator::EvaluatorResult(values[i], static_cast<Evaluator::EvaluatorResult::code>(codes[i])),
+                         out_);
+    }
+}
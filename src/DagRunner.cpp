@@ -0,0 +1,38 @@
+#include "DagRunner.h"
+
+#include "Session.h" // print_result
+
+DagRunner::DagRunner(std::size_t batch_lines_) : batch_lines(batch_lines_ > 0 ? batch_lines_ : 1) {
+    batch.reserve(batch_lines);
+}
+
+/*!
+ * Evaluates every line of the input.
+ *
+ * \param reader_ The input source.
+ * \param out_ Where the results are written, in the same order as the input lines.
+ */
+void DagRunner::run(LineReader &reader_, OutputWriter &out_) {
+    const char *first, *last; // the current input line, in the reader's buffer
+    bool more = true;
+    while (more) {
+        batch.clear();
+        expressions.clear();
+
+        while (batch.size() < batch_lines and (more = reader_.next(first, last))) {
+            Line line{parser.parse(first, last), 0};
+            if (line.parsed.type == Parser::ResultType::OK) {
+                evaluator.infix_to_postfix(parser.tokens(), program);
+                line.root = expressions.add(program);
+            }
+            batch.push_back(line);
+        }
+        n_lines += batch.size();
+
+        expressions.evaluate();
+
+        const Evaluator::EvaluatorResult none;
+        for (const Line &line : batch)
+            print_result(line.parsed, line.parsed.type == Parser::ResultType::OK ? expressions.result(line.root) : none, out_);
+    }
+}
@@ -1,87 +1,106 @@
 #include "Evaluator.h"
+#include <cstdint> // std::uint8_t
 #include <utility>
 
+//!< Pré-aloca as pilhas, que são reaproveitadas entre uma avaliação e outra (ou tiradas de arena_)
+Evaluator::Evaluator(Arena *arena_)
+        : expression(arena_), operators(ArenaAllocator<Token>(arena_)), values(ArenaAllocator<value_type>(arena_)) {
+    expression.reserve(64);
+    operators.reserve(32);
+    values.reserve(32);
+}
+
 //!< Verifica se o token é um operador
-bool Evaluator::is_operator(Token t) {
+bool Evaluator::is_operator(const Token &t) {
 
     return t.type == Token::token_t::OPERATOR;
 }
 
 //!< Verifica se o token é um operando
-bool Evaluator::is_operand(Token t) {
+bool Evaluator::is_operand(const Token &t) {
     return t.type == Token::token_t::OPERAND;
 }
 
+//!< Verifica se o token é uma variável
+bool Evaluator::is_variable(const Token &t) {
+    return t.type == Token::token_t::VARIABLE;
+}
+
 //!< Verifica o caractere informado é um parênteses aberto
-bool Evaluator::is_opening_scope(std::string c) {
-    return (c == "(");
+bool Evaluator::is_opening_scope(const Token &t) {
+    return t.type == Token::token_t::OPENING_SCOPE;
 }
 
 //!< Verifica o caractere informado é um parênteses aberto
-bool Evaluator::is_closing_scope(std::string c) {
-    return (c == ")");
+bool Evaluator::is_closing_scope(const Token &t) {
+    return t.type == Token::token_t::CLOSING_SCOPE;
 }
 
 //!< Verifica se é associação a direita
-bool Evaluator::is_right_association(std::string c) {
-    return c == "^";
+bool Evaluator::is_right_association(const Token &t) {
+    return t.op == Token::operator_t::CIRCUMFLEX;
 }
 
-//!< Executa uma operação
-Evaluator::EvaluatorResult Evaluator::execute_operator(std::string op1, std::string op2, Token opr) {
+namespace {
+
+typedef Evaluator::value_type value_type;
+typedef Evaluator::EvaluatorResult::code code_t;
+
+/// Computes num1_ / num2_ into r_.
+inline code_t divide(value_type num1_, value_type num2_, value_type &r_) {
+    if (num2_ == 0)
+        return Evaluator::EvaluatorResult::DIVISION_BY_ZERO;
+    // The only quotient that does not fit: the smallest value divided by -1.
+    if (num2_ == -1 and num1_ == Numeric::min())
+        return Evaluator::EvaluatorResult::NUMERIC_OVERFLOW;
+    r_ = static_cast<value_type>(num1_ / num2_);
+    return Evaluator::EvaluatorResult::OK;
+}
+
+/// Computes num1_ % num2_ into r_.
+inline code_t remainder(value_type num1_, value_type num2_, value_type &r_) {
+    if (num2_ == 0)
+        return Evaluator::EvaluatorResult::DIVISION_BY_ZERO;
+    r_ = num2_ == -1 ? 0 : static_cast<value_type>(num1_ % num2_); // min() % -1 is undefined in C++.
+    return Evaluator::EvaluatorResult::OK;
+}
 
-    std::string resultadoFinal;
+} // namespace
 
-    std::string::size_type sz;   // alias size_t
-    auto num1 = static_cast<int>(std::stol(op1, &sz));
-    auto num2 = static_cast<int>(std::stol(op2, &sz));
+//!< Executa uma operação
+Evaluator::EvaluatorResult Evaluator::execute_operator(value_type num1, value_type num2, Token::operator_t opr) {
 
     value_type resultado(0);
+    bool overflow = false;
     Evaluator::EvaluatorResult e;
 
-    //converte o Token para const char
-    const char *d = (opr.value).c_str();
-    switch (*d) {
-        case '^' :
-            resultado = static_cast<value_type>( pow(num1, num2));
-            break;
-        case '*' :
-            resultado = num1 * num2;
+    switch (opr) {
+        case Token::operator_t::CIRCUMFLEX :
+            overflow = Numeric::power(num1, num2, resultado);
             break;
-        case '/' :
-            if (num2 == 0) {
-                e.type_b = Evaluator::EvaluatorResult::DIVISION_BY_ZERO;
-                return e;
-            } else
-                resultado = num1 / num2;
+        case Token::operator_t::TIMES :
+            overflow = Numeric::mul(num1, num2, resultado);
             break;
-        case '%' :
-            if (num2 == 0) {
-                e.type_b = Evaluator::EvaluatorResult::DIVISION_BY_ZERO;
-                return e;
-            } else
-                resultado = num1 % num2;
+        case Token::operator_t::SLASH :
+            e.type_b = divide(num1, num2, e.value_b);
+            return e;
+        case Token::operator_t::MOD :
+            e.type_b = remainder(num1, num2, e.value_b);
+            return e;
+        case Token::operator_t::PLUS :
+            overflow = Numeric::add(num1, num2, resultado);
             break;
-        case '+' :
-            resultado = num1 + num2;
-            break;
-        case '-' :
-            resultado = num1 - num2;
+        case Token::operator_t::MINUS :
+            overflow = Numeric::sub(num1, num2, resultado);
             break;
         default:
             assert(false);
     }
 
-    if (resultado <= std::numeric_limits<Parser::required_int_type>::max()
-        and resultado >= std::numeric_limits<Parser::required_int_type>::min()) {
-
-        std::stringstream ss;
-        ss << resultado;
-        e.value_b = ss.str();
-        e.type_b = Evaluator::EvaluatorResult::OK;
-
-    } else
+    if (overflow)
         e.type_b = Evaluator::EvaluatorResult::NUMERIC_OVERFLOW;
+    else
+        e.value_b = resultado;
 
     return e;
 
@@ -89,103 +108,194 @@ Evaluator::EvaluatorResult Evaluator::execute_operator(std::string op1, std::str
 }
 
 //!< Executa uma expressão
-Evaluator::EvaluatorResult Evaluator::evaluate(std::vector<Token> infix) {
-
-    infix_to_postfix(std::move(infix));
-    std::stack<std::string> s;
-    Evaluator::EvaluatorResult resultado;
+Evaluator::EvaluatorResult Evaluator::evaluate(const Parser::token_list_type &infix) {
+    infix_to_postfix(infix);
+    return evaluate(expression);
+}
 
-    for (Token ch: expression) {
-        if (is_operand(ch)) s.push(ch.value);
+//!< Executa uma expressão já compilada, sem alocar memória (após a primeira vez)
+Evaluator::EvaluatorResult Evaluator::evaluate(const CompiledExpression &postfix) {
+    return evaluate(postfix, nullptr);
+}
 
-        else if (is_operator(ch)) {
-            auto op2 = s.top(); s.pop();
-            auto op1 = s.top(); s.pop();
+/*
+ * The postfix interpreter. With GCC and Clang it is threaded: every handler ends with its own
+ * jump (a computed goto) straight into the handler of the next instruction, looked up by opcode
+ * in a table, so the branch predictor sees which operation tends to follow which. The program
+ * keeps its opcodes, not handler addresses, since it is shared and never modified. Other
+ * compilers get the same handlers as the cases of a switch inside a loop.
+ */
+#if defined(__GNUC__)
+#define BARES_THREADED_DISPATCH 1
+#define BARES_HANDLER(label_, opcode_) label_:
+#define BARES_NEXT() \
+    do { if (++ip == end) goto done; goto *handlers[static_cast<std::uint8_t>(ip->op)]; } while (false)
+#else
+#define BARES_THREADED_DISPATCH 0
+#define BARES_HANDLER(label_, opcode_) case CompiledExpression::opcode_t::opcode_:
+#define BARES_NEXT() continue
+#endif
+
+// GCC would otherwise merge the jumps that end the handlers back into a single one.
+#if defined(__GNUC__) && !defined(__clang__)
+#define BARES_INTERPRETER __attribute__((optimize("no-crossjumping", "no-gcse")))
+#else
+#define BARES_INTERPRETER
+#endif
+
+//!< Executa uma expressão já compilada; variables guarda o valor de cada variável (opcode_t::LOAD)
+BARES_INTERPRETER
+Evaluator::EvaluatorResult Evaluator::evaluate(const CompiledExpression &postfix, const value_type *variables) {
+
+    // The top of the stack stays in tos; values holds the others, above a first slot that
+    // receives the (meaningless) tos of the empty stack.
+    arena_recycle(values, postfix.max_stack_depth());
+    values.resize(postfix.max_stack_depth());
+    value_type *below = values.data(); // próxima posição livre da pilha (abaixo de tos)
+    value_type tos = 0;
+    value_type lhs = 0;
+    Evaluator::EvaluatorResult resultado;
 
-            resultado = execute_operator(op1, op2, ch);
-            if (resultado.type_b != Evaluator::EvaluatorResult::OK)
-                return resultado;
-            else
-                s.push(resultado.value_b);
-        } else {
-            assert(false);
+    const CompiledExpression::Instruction *ip = postfix.data();
+    const CompiledExpression::Instruction *const end = ip + postfix.size();
+    assert(ip != end);
+
+#if BARES_THREADED_DISPATCH
+    static const void *const handlers[] = {&&op_push, &&op_add, &&op_sub, &&op_mul, &&op_div, &&op_mod, &&op_pow,
+                                           &&op_load};
+    static_assert(sizeof(handlers) / sizeof(handlers[0]) == static_cast<std::size_t>(CompiledExpression::opcode_t::LOAD) + 1,
+                  "one handler per opcode");
+    goto *handlers[static_cast<std::uint8_t>(ip->op)];
+#else
+    for (; ip != end; ++ip)
+        switch (ip->op) {
+#endif
+    BARES_HANDLER(op_push, PUSH)
+        *below++ = tos;
+        tos = ip->operand;
+        BARES_NEXT();
+    BARES_HANDLER(op_load, LOAD)
+        assert(variables != nullptr);
+        *below++ = tos;
+        tos = variables[ip->operand];
+        BARES_NEXT();
+    BARES_HANDLER(op_add, ADD)
+        lhs = *--below;
+        if (Numeric::add(lhs, tos, tos))
+            goto overflow;
+        BARES_NEXT();
+    BARES_HANDLER(op_sub, SUB)
+        lhs = *--below;
+        if (Numeric::sub(lhs, tos, tos))
+            goto overflow;
+        BARES_NEXT();
+    BARES_HANDLER(op_mul, MUL)
+        lhs = *--below;
+        if (Numeric::mul(lhs, tos, tos))
+            goto overflow;
+        BARES_NEXT();
+    BARES_HANDLER(op_div, DIV)
+        lhs = *--below;
+        resultado.type_b = divide(lhs, tos, tos);
+        if (resultado.type_b != Evaluator::EvaluatorResult::OK)
+            return resultado;
+        BARES_NEXT();
+    BARES_HANDLER(op_mod, MOD)
+        lhs = *--below;
+        resultado.type_b = remainder(lhs, tos, tos);
+        if (resultado.type_b != Evaluator::EvaluatorResult::OK)
+            return resultado;
+        BARES_NEXT();
+    BARES_HANDLER(op_pow, POW)
+        lhs = *--below;
+        if (Numeric::power(lhs, tos, tos))
+            goto overflow;
+        BARES_NEXT();
+#if BARES_THREADED_DISPATCH
+done:
+#else
         }
-    }
+#endif
 
-    resultado.value_b = s.top();
+    assert(below == values.data() + 1);
+    resultado.value_b = tos;
+    return resultado;
 
+overflow:
+    resultado.type_b = Evaluator::EvaluatorResult::NUMERIC_OVERFLOW;
     return resultado;
 }
 
+#undef BARES_INTERPRETER
+#undef BARES_THREADED_DISPATCH
+#undef BARES_HANDLER
+#undef BARES_NEXT
+
 //!< Converte a expressão infixa para posfixa
-void Evaluator::infix_to_postfix(std::vector<Token> infix) {
-    std::string postfix;
-    std::stack<std::string> s;
+void Evaluator::infix_to_postfix(const Parser::token_list_type &infix) {
+    infix_to_postfix(infix, expression);
+}
+
+//!< Compila a expressão infixa em um programa posfixo que pode ser avaliado várias vezes
+CompiledExpression Evaluator::compile(const Parser::token_list_type &infix) {
+    CompiledExpression postfix;
+    infix_to_postfix(infix, postfix);
+    return postfix;
+}
 
-    for (Token c : infix) {
+//!< Converte a expressão infixa para o programa posfixo postfix
+void Evaluator::infix_to_postfix(const Parser::token_list_type &infix, CompiledExpression &postfix) {
+    postfix.clear();
+    postfix.reserve(infix.size());
+    arena_recycle(operators, infix.size());
+
+    for (const Token &c : infix) {
         if (is_operand(c)) {
-            Token add;
-            add.type = c.type;
-            add.value = c.value;
-            expression.push_back(add);;
+            postfix.push(c.value);
+        } else if (is_variable(c)) {
+            postfix.load(c.value);
         } else if (is_operator(c)) {
             //Remove elementos com prioridade superior
-            while (not s.empty() and has_higher_precedence(s.top(), c.value)) {
-                Token add;
-                add.type = c.type;
-                add.value = s.top(); s.pop();
-                expression.push_back(add);
+            while (not operators.empty() and has_higher_precedence(operators.back(), c)) {
+                postfix.emit(CompiledExpression::opcode(operators.back().op)); operators.pop_back();
             }
             // Colocando o operador na fila
-            s.push(c.value);
-        } else if (is_opening_scope(c.value)) {
-            s.push(c.value);
-        } else if (is_closing_scope(c.value)) {
+            operators.push_back(c);
+        } else if (is_opening_scope(c)) {
+            operators.push_back(c);
+        } else if (is_closing_scope(c)) {
             //Remove todos os elementos exceto '('
-            while (not is_opening_scope(s.top()) and not s.empty()) {
-                Token add;
-                add.type = Token::token_t::OPERATOR;
-                add.value = s.top(); s.pop();
-                expression.push_back(add);
+            while (not operators.empty() and not is_opening_scope(operators.back())) {
+                postfix.emit(CompiledExpression::opcode(operators.back().op)); operators.pop_back();
             }
-            s.pop();
+            operators.pop_back();
         }
     }
 
-    while (not s.empty()) {
-        Token add;
-        add.type = Token::token_t::OPERATOR;
-        add.value = s.top(); s.pop();
-        expression.push_back(add);
+    while (not operators.empty()) {
+        postfix.emit(CompiledExpression::opcode(operators.back().op)); operators.pop_back();
     }
 }
 
 //!< Precedências das operações
-int Evaluator::get_precedence(std::string c) {
+int Evaluator::get_precedence(const Token &t) {
+    if (is_opening_scope(t))
+        return 0;
+
     int prioridade = 0;
-    const char *d = c.c_str();
-    switch (*d) {
-        case '^':
+    switch (t.op) {
+        case Token::operator_t::CIRCUMFLEX:
             prioridade = 3;
             break;
-        case '*':
+        case Token::operator_t::TIMES:
+        case Token::operator_t::SLASH:
+        case Token::operator_t::MOD:
             prioridade = 2;
             break;
-        case '/':
-            prioridade = 2;
-            break;
-        case '%':
-            prioridade = 2;
-            break;
-        case '+':
-            prioridade = 1;
-            break;
-        case '-':
+        case Token::operator_t::PLUS:
+        case Token::operator_t::MINUS:
             prioridade = 1;
             break;
-        case '(':
-            prioridade = 0;
-            break;
         default:
             assert(false);
     }
@@ -194,10 +304,10 @@ int Evaluator::get_precedence(std::string c) {
 }
 
 //!< Verificar precedência dos operadores
-bool Evaluator::has_higher_precedence(std::string op1, std::string op2) {
+bool Evaluator::has_higher_precedence(const Token &op1, const Token &op2) {
 
     int p1 = get_precedence(op1);
-    int p2 = get_precedence(std::move(op2));
+    int p2 = get_precedence(op2);
 
     if (p1 == p2 and is_right_association(op1))
         return false;
@@ -0,0 +1,70 @@
+#include "ExpressionDag.h"
+
+#include <cassert> // assert
+
+//!< Devolve o nó equivalente a k_, criando-o se ele ainda não existir
+ExpressionDag::node_id ExpressionDag::intern(const Key &k_) {
+    ++n_requested;
+    auto it = table.find(k_);
+    if (it != table.end())
+        return it->second;
+
+    auto id = static_cast<node_id>(nodes.size());
+    Node n;
+    n.op = k_.op;
+    n.value = k_.value;
+    n.left = k_.a;
+    n.right = k_.b;
+    nodes.push_back(n);
+    table.emplace(k_, id);
+    ++n_created;
+    return id;
+}
+
+/*!
+ * Adds an expression to the DAG.
+ *
+ * \param postfix_ The compiled expression (without variables).
+ * \return The id of the node that represents the whole expression.
+ */
+ExpressionDag::node_id ExpressionDag::add(const CompiledExpression &postfix_) {
+    stack.clear();
+    for (const CompiledExpression::Instruction &ins : postfix_) {
+        assert(ins.op != CompiledExpression::opcode_t::LOAD);
+        if (ins.op == CompiledExpression::opcode_t::PUSH)
+            stack.push_back(intern(Key{ins.op, ins.operand, 0, 0}));
+        else {
+            node_id right = stack.back(); stack.pop_back();
+            node_id left = stack.back(); stack.pop_back();
+            stack.push_back(intern(Key{ins.op, 0, left, right}));
+        }
+    }
+    assert(stack.size() == 1);
+    return stack.back();
+}
+
+//!< Avalia, uma única vez, cada nó criado desde a última chamada
+void ExpressionDag::evaluate() {
+    for (; n_evaluated < nodes.size(); ++n_evaluated) {
+        Node &n = nodes[n_evaluated];
+        if (n.op == CompiledExpression::opcode_t::PUSH) {
+            n.result = Evaluator::EvaluatorResult(n.value);
+            continue;
+        }
+        const Evaluator::EvaluatorResult &l = nodes[n.left].result;
+        const Evaluator::EvaluatorResult &r = nodes[n.right].result;
+        if (l.type_b != Evaluator::EvaluatorResult::OK)
+            n.result = l;
+        else if (r.type_b != Evaluator::EvaluatorResult::OK)
+            n.result = r;
+        else
+            n.result = evaluator.execute_operator(l.value_b, r.value_b, CompiledExpression::operator_of(n.op));
+    }
+}
+
+//!< Esvazia o DAG, mantendo a memória alocada
+void ExpressionDag::clear() {
+    nodes.clear();
+    table.clear();
+    n_evaluated = 0;
+}
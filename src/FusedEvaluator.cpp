@@ -0,0 +1,227 @@
+#include "FusedEvaluator.h"
+
+
+#include "Scanner.h"
+
+/// Returns the column (starting at 1) of the current character.
+Parser::ResultType::size_type FusedEvaluator::column() const {
+    return static_cast<Parser::ResultType::size_type>(curr - first) + 1;
+}
+
+/// Ignores any white space or tabs in the expression until reach a valid character or end of input.
+void FusedEvaluator::skip_ws() {
+    curr = Scanner::skip_blanks(curr, last);
+}
+
+/// Returns the operator at the current character (without consuming it), or operator_t::NONE.
+Token::operator_t FusedEvaluator::peek_operator() {
+    if (end_input())
+        return Token::operator_t::NONE;
+    switch (*curr) {
+        case '+':
+            return Token::operator_t::PLUS;
+        case '-':
+            return Token::operator_t::MINUS;
+        case '*':
+            return Token::operator_t::TIMES;
+        case '/':
+            return Token::operator_t::SLASH;
+        case '%':
+            return Token::operator_t::MOD;
+        case '^':
+            return Token::operator_t::CIRCUMFLEX;
+        default:
+            return Token::operator_t::NONE;
+    }
+}
+
+/// Operator precedence, the same used by the Evaluator.
+int FusedEvaluator::precedence(Token::operator_t op_) {
+    switch (op_) {
+        case Token::operator_t::CIRCUMFLEX:
+            return 3;
+        case Token::operator_t::TIMES:
+        case Token::operator_t::SLASH:
+        case Token::operator_t::MOD:
+            return 2;
+        default:
+            return 1;
+    }
+}
+
+/// Computes lhs_ op_ rhs_. After the first evaluation error the remaining operations are skipped.
+FusedEvaluator::value_type FusedEvaluator::apply(Token::operator_t op_, value_type lhs_, value_type rhs_) {
+    if (error != Evaluator::EvaluatorResult::OK)
+        return 0;
+    auto result = evaluator.execute_operator(lhs_, rhs_, op_);
+    error = result.type_b;
+    return result.value_b;
+}
+
+/// Pushes op_, after carrying out the pending operators that come before it in postfix order.
+void FusedEvaluator::push_operator(Token::operator_t op_) {
+    int p = precedence(op_);
+    // The same rule as Evaluator::has_higher_precedence(): "^" is right associative.
+    while (not operators.empty() and operators.back() != Token::operator_t::NONE) {
+        int p_top = precedence(operators.back());
+        if (p_top < p or (p_top == p and operators.back() == Token::operator_t::CIRCUMFLEX))
+            break;
+        reduce();
+    }
+    operators.push_back(op_);
+}
+
+/// Applies the operator on top of the stack to the two operands on top of the stack.
+void FusedEvaluator::reduce() {
+    Token::operator_t op = operators.back();
+    operators.pop_back();
+    value_type rhs = values.back();
+    values.pop_back();
+    values.back() = apply(op, values.back(), rhs);
+}
+
+/*!
+ * Parses and evaluates
+ * ```
+ *  <expr> := <term>,{ ("+"|"-"|"*"|"/"|"%"|"^"),<term> };
+ *  <term> := "(",<expr>,")" | <integer>;
+ * ```
+ * without recursion, the same way as Parser::expression(): a "(" opens a scope, and when an
+ * expression ends the ")" of the innermost scope is expected.
+ */
+Parser::ResultType FusedEvaluator::expression(value_type &value_) {
+    values.clear();
+    operators.clear();
+    scopes.clear();
+    bool after_operator = false; // whether the next term follows an operator.
+    while (true) {
+        //=== <term>
+        skip_ws();
+        if (not end_input() and *curr == '(') {
+            if (scopes.size() == max_scopes)
+                return Parser::ResultType(Parser::ResultType::NESTING_TOO_DEEP, column());
+            ++curr;
+            operators.push_back(Token::operator_t::NONE);
+            scopes.push_back(after_operator);
+            after_operator = false;
+            continue;
+        }
+        value_type value = 0;
+        auto result = term(value);
+        if (result.type != Parser::ResultType::OK)
+            return failure(result, after_operator);
+        values.push_back(value);
+
+        //=== { operator,<term> }, then the ")" of each scope that ends here.
+        while (true) {
+            skip_ws();
+            Token::operator_t op = peek_operator();
+            if (op != Token::operator_t::NONE) {
+                ++curr;
+                push_operator(op);
+                after_operator = true;
+                break;
+            }
+
+            if (scopes.empty()) {
+                while (not operators.empty())
+                    reduce();
+                value_ = values.back();
+                return Parser::ResultType(Parser::ResultType::OK);
+            }
+            bool scope_after_operator = scopes.back() != 0;
+            scopes.pop_back();
+            if (end_input() or *curr != ')')
+                return failure(Parser::ResultType(Parser::ResultType::MISSING_CLOSING, column()), scope_after_operator);
+            ++curr;
+            while (operators.back() != Token::operator_t::NONE)
+                reduce();
+            operators.pop_back();
+        }
+    }
+}
+
+/// The error an expression ends with when one of its terms fails with result_ (see Parser::failure()).
+Parser::ResultType FusedEvaluator::failure(Parser::ResultType result_, bool after_operator_) const {
+    if (result_.type != Parser::ResultType::INTEGER_OUT_OF_RANGE and end_input()) {
+        bool any = after_operator_;
+        for (std::size_t i = 0; i < scopes.size() and not any; ++i)
+            any = scopes[i] != 0;
+        if (any)
+            result_.type = Parser::ResultType::MISSING_TERM;
+    }
+    return result_;
+}
+
+/// Parses and evaluates `<term> := <integer>;` (parenthesized expressions are handled by expression()).
+Parser::ResultType FusedEvaluator::term(value_type &value_) {
+    Parser::ResultType::size_type col = column();
+
+    Parser::input_int_type value = 0;
+    bool negative = false;
+    auto result = integer(value, negative);
+    if (result.type == Parser::ResultType::OK) {
+        if (value <= Numeric::limit(negative))
+            value_ = Numeric::from_magnitude(value, negative);
+        else
+            return Parser::ResultType(Parser::ResultType::INTEGER_OUT_OF_RANGE, col);
+    }
+    return result;
+}
+
+/// Parses `<integer> := 0 | {"-"},<natural_number>;` the same way as Parser::integer().
+Parser::ResultType FusedEvaluator::integer(Parser::input_int_type &value_, bool &negative_) {
+    negative_ = false;
+    if (not end_input() and *curr == '0') {
+        ++curr;
+        value_ = 0;
+        return Parser::ResultType(Parser::ResultType::OK);
+    }
+
+    int cont = 0;
+    while (true) {
+        skip_ws();
+        if (end_input() or *curr != '-')
+            break;
+        ++curr;
+        ++cont;
+    }
+
+    if (end_input() or *curr < '1' or *curr > '9')
+        return Parser::ResultType(Parser::ResultType::ILL_FORMED_INTEGER, column());
+
+    value_ = 0;
+    for (const char *digits_end = Scanner::skip_digits(curr, last); curr != digits_end; ++curr)
+        value_ = Numeric::accumulate(value_, *curr - '0');
+
+    negative_ = cont % 2 == 1;
+    return Parser::ResultType(Parser::ResultType::OK);
+}
+
+/*!
+ * This is the engine's entry point.
+ *
+ * \param first_ The first character of the expression to parse and evaluate.
+ * \param last_ One past the last character.
+ * \param value_ Receives the value (or the evaluation error) when the expression is valid.
+ * \return The parsing result, as Parser::parse() would return it.
+ */
+Parser::ResultType FusedEvaluator::evaluate(const char *first_, const char *last_, Evaluator::EvaluatorResult &value_) {
+    first = curr = first_;
+    last = last_;
+    error = Evaluator::EvaluatorResult::OK;
+
+    skip_ws();
+    if (end_input())
+        return Parser::ResultType(Parser::ResultType::UNEXPECTED_END_OF_EXPRESSION, column());
+
+    value_type value = 0;
+    auto result = expression(value);
+    if (result.type == Parser::ResultType::OK) {
+        skip_ws();
+        if (not end_input())
+            return Parser::ResultType(Parser::ResultType::EXTRANEOUS_SYMBOL, column());
+        value_ = Evaluator::EvaluatorResult(error == Evaluator::EvaluatorResult::OK ? value : 0, error);
+    }
+    return result;
+}
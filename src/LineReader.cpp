@@ -0,0 +1,152 @@
+#include "LineReader.h"
+
+#include <cerrno>     // errno
+#include <cstdint>    // SIZE_MAX
+#include <cstring>    // std::memchr, std::memmove
+#include <sys/mman.h> // mmap, madvise, munmap
+#include <sys/stat.h> // fstat
+#include <unistd.h>   // read, lseek, sysconf
+
+LineReader::LineReader(int fd_, std::size_t buffer_size_) : fd(fd_) {
+    if (not map())
+        buf.resize(buffer_size_ > 0 ? buffer_size_ : default_buffer_size);
+}
+
+LineReader::~LineReader() {
+    if (map_base != nullptr)
+        munmap(map_base, map_length);
+}
+
+/*!
+ * Maps the rest of the file, from the current offset of the descriptor, if it is a regular file.
+ *
+ * \return false if the source must be read with read(2) instead.
+ */
+bool LineReader::map() {
+    struct stat st{};
+    if (fstat(fd, &st) != 0 or not S_ISREG(st.st_mode))
+        return false;
+    off_t offset = lseek(fd, 0, SEEK_CUR);
+    if (offset < 0 or offset >= st.st_size
+        or static_cast<unsigned long long>(st.st_size) > static_cast<unsigned long long>(SIZE_MAX))
+        return false;
+
+    // The mapping must begin at a page boundary.
+    auto page = static_cast<off_t>(sysconf(_SC_PAGESIZE));
+    off_t start = offset - offset % page;
+    auto length = static_cast<std::size_t>(st.st_size - start);
+    void *base = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, start);
+    if (base == MAP_FAILED)
+        return false;
+    madvise(base, length, MADV_SEQUENTIAL);
+
+    map_base = base;
+    map_length = length;
+    map_curr = static_cast<const char *>(base) + (offset - start);
+    map_end = static_cast<const char *>(base) + length;
+    return true;
+}
+
+/// Reads more of the source into the free space at the end of the buffer. Returns false when nothing else can be read.
+bool LineReader::read_more() {
+    while (not eof) {
+        ssize_t n = ::read(fd, buf.data() + len, buf.size() - len);
+        if (n > 0) {
+            len += static_cast<std::size_t>(n);
+            return true;
+        }
+        if (n < 0 and errno == EINTR)
+            continue;
+        if (n < 0)
+            error = true;
+        eof = true;
+    }
+    return false;
+}
+
+/*!
+ * Extracts the next line from the source.
+ *
+ * A line of a mapped file is just found with memchr() and handed out in the mapping.
+ *
+ * When the buffer ends in the middle of a line, the beginning of the line is moved to the
+ * front of the buffer and the rest is read behind it, so the line can still be handed out
+ * in place. A line that does not fit in the buffer at all is assembled in `spill`. The last
+ * line of the input does not need a terminating '\n'; an input ending with '\n' does not
+ * produce an extra empty line.
+ *
+ * \param first_ Receives the first character of the line.
+ * \param last_ Receives one past the last character of the line.
+ * \return true if a line was extracted; false at end of input.
+ */
+bool LineReader::next(const char *&first_, const char *&last_) {
+    if (map_base != nullptr) {
+        if (map_curr == map_end)
+            return false;
+        auto *nl = static_cast<const char *>(std::memchr(map_curr, '\n', static_cast<std::size_t>(map_end - map_curr)));
+        first_ = map_curr;
+        last_ = nl != nullptr ? nl : map_end;
+        map_curr = nl != nullptr ? nl + 1 : map_end;
+        return true;
+    }
+
+    std::size_t scanned = pos; // the bytes of the line before scanned have no '\n'
+    bool spilled = false;
+    while (true) {
+        auto *nl = static_cast<const char *>(std::memchr(buf.data() + scanned, '\n', len - scanned));
+        if (nl != nullptr) {
+            first_ = buf.data() + pos;
+            last_ = nl;
+            if (spilled) {
+                spill.append(first_, last_);
+                first_ = spill.data();
+                last_ = first_ + spill.size();
+            }
+            pos = static_cast<std::size_t>(nl - buf.data()) + 1;
+            return true;
+        }
+
+        if (pos == 0 and len == buf.size()) {
+            if (not spilled)
+                spill.clear();
+            spill.append(buf.data(), len);
+            spilled = true;
+            len = 0;
+        } else if (pos > 0) {
+            std::memmove(buf.data(), buf.data() + pos, len - pos);
+            len -= pos;
+            pos = 0;
+        }
+        scanned = len;
+
+        if (not read_more()) {
+            if (len == 0 and not spilled)
+                return false;
+            first_ = buf.data();
+            last_ = first_ + len;
+            if (spilled) {
+                spill.append(first_, last_);
+                first_ = spill.data();
+                last_ = first_ + spill.size();
+            }
+            pos = len;
+            return true;
+        }
+    }
+}
+
+/*!
+ * Extracts the next line from the source into a string owned by the caller.
+ *
+ * \param line_ Receives the line contents; its previous capacity is reused.
+ * \return true if a line was extracted; false at end of input.
+ */
+bool LineReader::next(std::string &line_) {
+    const char *first, *last;
+    if (not next(first, last)) {
+        line_.clear();
+        return false;
+    }
+    line_.assign(first, last);
+    return true;
+}
@@ -0,0 +1,100 @@
+#include "OutputWriter.h"
+
+#include <cerrno>   // errno
+#include <unistd.h> // write
+
+namespace {
+/// "00" to "99", used to format two digits per step.
+const char digit_pairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+}
+
+OutputWriter::OutputWriter(int fd_, std::size_t capacity_)
+        : fd(fd_), buf(capacity_ > max_int_chars ? capacity_ : default_capacity) {/* empty */}
+
+OutputWriter::~OutputWriter() {
+    flush();
+}
+
+/*!
+ * Formats an integer backwards, two digits at a time.
+ *
+ * \param end_ One past the last position available; at least max_int_chars positions before it must be usable.
+ * \param v_ The value.
+ * \return Pointer to the first character of the text, which ends at end_.
+ */
+char *OutputWriter::format_int(char *end_, int_type v_) {
+    // The magnitude is computed as unsigned, so the smallest value does not overflow.
+    unsigned_int_type u = v_ < 0 ? unsigned_int_type(0) - static_cast<unsigned_int_type>(v_)
+                                 : static_cast<unsigned_int_type>(v_);
+    char *p = end_;
+    while (u >= 100) {
+        const char *pair = digit_pairs + static_cast<std::size_t>(u % 100) * 2;
+        u /= 100;
+        *--p = pair[1];
+        *--p = pair[0];
+    }
+    if (u >= 10) {
+        const char *pair = digit_pairs + static_cast<std::size_t>(u) * 2;
+        *--p = pair[1];
+        *--p = pair[0];
+    } else
+        *--p = static_cast<char>('0' + static_cast<int>(u));
+    if (v_ < 0)
+        *--p = '-';
+    return p;
+}
+
+//!< Escreve um inteiro diretamente no buffer
+void OutputWriter::write_int(int_type v_) {
+    if (buf.size() - len < max_int_chars)
+        make_room(max_int_chars);
+    char tmp[max_int_chars];
+    char *first = format_int(tmp + max_int_chars, v_);
+    auto n = static_cast<std::size_t>(tmp + max_int_chars - first);
+    std::memcpy(buf.data() + len, first, n);
+    len += n;
+}
+
+/// Makes room for n_ more characters: flushes a file writer, grows a memory writer.
+void OutputWriter::make_room(std::size_t n_) {
+    if (fd < 0) {
+        std::size_t size = buf.size();
+        while (size - len < n_)
+            size *= 2;
+        buf.resize(size);
+    } else
+        flush();
+}
+
+//!< Escreve o buffer no descritor de arquivo
+void OutputWriter::flush() {
+    if (fd < 0 or len == 0)
+        return;
+    write_through(buf.data(), len);
+    len = 0;
+}
+
+/// Writes n_ characters straight to the file descriptor, retrying after partial writes.
+void OutputWriter::write_through(const char *s_, std::size_t n_) {
+    while (n_ > 0 and not error) {
+        ssize_t w = ::write(fd, s_, n_);
+        if (w < 0) {
+            if (errno == EINTR)
+                continue;
+            error = true;
+            break;
+        }
+        s_ += w;
+        n_ -= static_cast<std::size_t>(w);
+    }
+}
@@ -1,7 +1,23 @@
 #include "Parser.h"
+#include "Scanner.h"
 
 /// Converts the input character c_ into its corresponding terminal symbol code.
+/*!
+ * The conversion is a lookup in a 256-entry table, filled once from classify().
+ */
 Parser::terminal_symbol_t Parser::lexer(char c_) const {
+    static const struct Table {
+        terminal_symbol_t symbols[256];
+        Table() {
+            for (int c = 0; c < 256; ++c)
+                symbols[c] = classify(static_cast<char>(c));
+        }
+    } table;
+    return table.symbols[static_cast<unsigned char>(c_)];
+}
+
+/// Classifies the character c_ (used to build the lexer() table).
+Parser::terminal_symbol_t Parser::classify(char c_) {
     switch (c_) {
         case '+':
             return terminal_symbol_t::TS_PLUS;
@@ -35,25 +51,54 @@ Parser::terminal_symbol_t Parser::lexer(char c_) const {
         case '8':
         case '9':
             return terminal_symbol_t::TS_NON_ZERO_DIGIT;
+        case '_':
+            return terminal_symbol_t::TS_LETTER;
         case '\0':
             return terminal_symbol_t::TS_EOS; // end of string: the $ terminal symbol
         default:
             break;
     }
+    if ((c_ >= 'a' and c_ <= 'z') or (c_ >= 'A' and c_ <= 'Z'))
+        return terminal_symbol_t::TS_LETTER;
     return terminal_symbol_t::TS_INVALID;
 }
 
+/// The binary operator denoted by the terminal symbol s_, or operator_t::NONE.
+Token::operator_t Parser::binary_operator(terminal_symbol_t s_) {
+    switch (s_) {
+        case terminal_symbol_t::TS_PLUS:
+            return Token::operator_t::PLUS;
+        case terminal_symbol_t::TS_MINUS:
+            return Token::operator_t::MINUS;
+        case terminal_symbol_t::TS_TIMES:
+            return Token::operator_t::TIMES;
+        case terminal_symbol_t::TS_SLASH:
+            return Token::operator_t::SLASH;
+        case terminal_symbol_t::TS_MOD:
+            return Token::operator_t::MOD;
+        case terminal_symbol_t::TS_CIRCUMFLEX:
+            return Token::operator_t::CIRCUMFLEX;
+        default:
+            return Token::operator_t::NONE;
+    }
+}
+
 /// Consumes a valid character from the input source expression.
 void Parser::next_symbol() {
     // Advances iterator to the next valid symbol for processing
     std::advance(it_curr_symb, 1);
 }
 
+/// Returns the column (starting at 1) of the current character.
+Token::size_type Parser::curr_col() const {
+    return static_cast<Token::size_type>(std::distance(expr_begin, it_curr_symb) + 1);
+}
+
 /// Checks whether we reached the end of the input expression string.
 bool Parser::end_input() const {
     // "Fim de entrada" ocorre quando o iterador chega ao
-    // fim da string que guarda a expressão.
-    return it_curr_symb == expr.end(); // Stub
+    // fim da expressão.
+    return it_curr_symb == expr_end; // Stub
 }
 
 /// Returns the result of trying to match the current character with c_, **without** consuming the current character from the input expression.
@@ -88,12 +133,13 @@ bool Parser::expect(terminal_symbol_t c_) {
 
 /// Ignores any white space or tabs in the expression until reach a valid character or end of input.
 void Parser::skip_ws() {
-    // Skip white spaces, while at the same time, check for end of string.
-    while ((!end_input()) &&
-           ((lexer(*it_curr_symb) == Parser::terminal_symbol_t::TS_WS) ||
-            (lexer(*it_curr_symb) == Parser::terminal_symbol_t::TS_TAB))) {
-        next_symbol();
-    }
+    // The Scanner jumps over the whole run at once (16 or 32 bytes per step when possible).
+    it_curr_symb = Scanner::skip_blanks(it_curr_symb, expr_end);
+}
+
+/// Returns a pointer to the current character.
+const char *Parser::curr_ptr() const {
+    return it_curr_symb;
 }
 
 //=== Non Terminal Symbols (NTS) methods.
@@ -101,86 +147,113 @@ void Parser::skip_ws() {
 /// Validates (i.e. returns true or false) and consumes an expression from the input string.
 /*! This method parses a valid expression from the input and, at the same time, it tokenizes its components.
  *
- * Production rule is:
+ * Production rules are:
  * ```
  *  <expr> := <term>,{ ("+"|"-"),<term> };
+ *  <term> := "(",<expr>,")" | <integer> | <identifier>;
  * ```
  * An expression might be just a term or one or more terms with '+'/'-' between them.
+ *
+ * The two rules are parsed together, without recursion: a "(" pushes a scope and starts the inner
+ * expression; when an expression ends, the ")" of the innermost scope is expected and the enclosing
+ * expression goes on. Each scope remembers whether its "(" followed an operator, which is what a
+ * recursive parser would know from its call stack (see failure()).
  */
 Parser::ResultType Parser::expression() {
-    skip_ws();
-    auto result = term();
-    while (result.type == ResultType::OK) {
-
-        if (expect(terminal_symbol_t::TS_PLUS)) {
-            token_list.emplace_back("+", Token::token_t::OPERATOR);
-        } else if (expect(terminal_symbol_t::TS_MINUS)) {
-            token_list.emplace_back("-", Token::token_t::OPERATOR);
-        } else if (expect(terminal_symbol_t::TS_TIMES)) {
-            token_list.emplace_back("*", Token::token_t::OPERATOR);
-        } else if (expect(terminal_symbol_t::TS_SLASH)) {
-            token_list.emplace_back("/", Token::token_t::OPERATOR);
-        } else if (expect(terminal_symbol_t::TS_MOD)) {
-            token_list.emplace_back("%", Token::token_t::OPERATOR);
-        } else if (expect(terminal_symbol_t::TS_CIRCUMFLEX)) {
-            token_list.emplace_back("^", Token::token_t::OPERATOR);
-        } else {
-            return result;
+    scopes.clear();
+    bool after_operator = false; // whether the next term follows an operator.
+    while (true) {
+        //=== <term>
+        skip_ws();
+        Token::size_type col = curr_col();
+        if (expect(terminal_symbol_t::TS_OPENING_SCOPE)) {
+            if (scopes.size() == max_scopes)
+                return ResultType(ResultType::NESTING_TOO_DEEP, col);
+            token_list.emplace_back(Token::token_t::OPENING_SCOPE, Token::operator_t::NONE, 0, col);
+            scopes.push_back(after_operator);
+            after_operator = false;
+            continue;
         }
+        ResultType result = term();
+        if (result.type != ResultType::OK)
+            return failure(result, after_operator);
+
+        //=== { ("+"|"-"),<term> }, then the ")" of each scope that ends here.
+        while (true) {
+            skip_ws();
+            col = curr_col();
+            Token::operator_t op = end_input() ? Token::operator_t::NONE : binary_operator(lexer(*it_curr_symb));
+            if (op != Token::operator_t::NONE) {
+                next_symbol();
+                token_list.emplace_back(Token::token_t::OPERATOR, op, 0, col);
+                after_operator = true;
+                break;
+            }
 
-        result = term();
-        if (result.type != ResultType::OK and result.type != ResultType::INTEGER_OUT_OF_RANGE and end_input()) {
-            result.type = ResultType::MISSING_TERM;
-            return result;
+            if (scopes.empty())
+                return ResultType(ResultType::OK);
+            bool scope_after_operator = scopes.back() != 0;
+            scopes.pop_back();
+            if (not expect(terminal_symbol_t::TS_CLOSING_SCOPE))
+                return failure(ResultType(ResultType::MISSING_CLOSING, curr_col()), scope_after_operator);
+            token_list.emplace_back(Token::token_t::CLOSING_SCOPE, Token::operator_t::NONE, 0, col);
         }
     }
+}
 
-    return result;
+/*!
+ * The error an expression ends with when one of its terms fails with result_.
+ *
+ * In the recursive form of the grammar the error goes back through every open scope, and each
+ * expression that gets an error from a term following an operator turns it into MISSING_TERM
+ * when the input is over (unless the integer was out of range). Since the input does not move
+ * meanwhile, that happens if the failed term, or any open "(", follows an operator.
+ *
+ * \param result_ The error of the term.
+ * \param after_operator_ Whether the failed term follows an operator.
+ */
+Parser::ResultType Parser::failure(ResultType result_, bool after_operator_) const {
+    if (result_.type != ResultType::INTEGER_OUT_OF_RANGE and end_input()) {
+        bool any = after_operator_;
+        for (std::size_t i = 0; i < scopes.size() and not any; ++i)
+            any = scopes[i] != 0;
+        if (any)
+            result_.type = ResultType::MISSING_TERM;
+    }
+    return result_;
 }
 
-/// Validates (i.e. returns true or false) and consumes a term from the input string.
+/// Validates (i.e. returns true or false) and consumes a term other than a parenthesized expression.
 /*! This method parses a valid term from the input.
  *
  * Production rule is:
  * ```
- *  <term> := <integer>;
+ *  <term> := "(",<expr>,")" | <integer> | <identifier>;
  * ```
- * A term is made of a single integer.
+ * A term is an integer, a variable (if identifiers are enabled) or an expression between parentheses;
+ * the parentheses are handled by expression().
  *
  * @return true if a term has been successfuly parsed from the input; false otherwise.
  */
 Parser::ResultType Parser::term() {
-    skip_ws();
-    std::string::iterator it_begin = it_curr_symb;
+    const char *it_begin = it_curr_symb;
+    Token::size_type col = curr_col();
 
     ResultType resultado;
-    if (expect(terminal_symbol_t::TS_OPENING_SCOPE)) {
-        token_list.emplace_back("(", Token::token_t::OPENING_SCOPE);
-        resultado = expression();
-
-        if (resultado.type == ResultType::OK) {
-            if (not expect(terminal_symbol_t::TS_CLOSING_SCOPE))
-                return ResultType(ResultType::MISSING_CLOSING,
-                                  static_cast<ResultType::size_type>(std::distance(expr.begin(), it_curr_symb) + 1));
-
-            token_list.emplace_back(")", Token::token_t::CLOSING_SCOPE);
-        }
+    if (identifiers and peek(terminal_symbol_t::TS_LETTER)) {
+        token_list.emplace_back(Token::token_t::VARIABLE, Token::operator_t::NONE, identifier(), col);
+        resultado = ResultType(ResultType::OK);
     } else {
-        resultado = integer();
+        input_int_type value = 0;
+        bool negative = false;
+        resultado = integer(value, negative);
         if (resultado.type == ResultType::OK) {
-            std::string num;
-            num.insert(num.begin(), it_begin + resultado.at_col, it_curr_symb);
-
-            std::string::iterator end_pos = std::remove(num.begin(), num.end(), ' ');
-            num.erase(end_pos, num.end());
-
-            input_int_type value = std::stoll(num);
-            if (value <= std::numeric_limits<Parser::required_int_type>::max()
-                && value >= std::numeric_limits<Parser::required_int_type>::min()) {
-                token_list.emplace_back(num, Token::token_t::OPERAND);
+            if (value <= Numeric::limit(negative)) {
+                token_list.emplace_back(Token::token_t::OPERAND, Token::operator_t::NONE,
+                                        Numeric::from_magnitude(value, negative), col);
             } else {
                 resultado.type = ResultType::INTEGER_OUT_OF_RANGE;
-                resultado.at_col = static_cast<ResultType::size_type>(std::distance(expr.begin(), it_begin) + 1);
+                resultado.at_col = static_cast<ResultType::size_type>(std::distance(expr_begin, it_begin) + 1);
             }
         }
     }
@@ -189,7 +262,7 @@ Parser::ResultType Parser::term() {
 }
 
 /// Validates (i.e. returns true or false) and consumes an integer from the input string.
-/*! This method parses a valid integer from the input and, at the same time, add the integer to the token list.
+/*! This method parses a valid integer from the input and computes its value.
  *
  * Production rule is:
  * ```
@@ -197,10 +270,14 @@ Parser::ResultType Parser::term() {
  * ```
  * A integer might be a zero or a natural number, which, in turn, might begin with an unary minus.
  *
+ * @param value_ receives the absolute value of the integer.
+ * @param negative_ receives whether the unary minus signs make it negative.
  * @return true if an integer has been successfuly parsed from the input; false otherwise.
  */
-Parser::ResultType Parser::integer() {
+Parser::ResultType Parser::integer(input_int_type &value_, bool &negative_) {
+    negative_ = false;
     if (accept(terminal_symbol_t::TS_ZERO)) {
+        value_ = 0;
         return ResultType(ResultType::OK);
     }
 
@@ -209,86 +286,103 @@ Parser::ResultType Parser::integer() {
         cont++;
     }
 
-    if (cont % 2 == 1)
-        cont -= 1;
-
-    auto resultado = natural_number();
-
-    if (resultado.type == ResultType::OK)
-        resultado.at_col = static_cast<ResultType::size_type>(cont);
-
-    return resultado;
+    // Each pair of unary minus cancels out.
+    negative_ = cont % 2 == 1;
+    return natural_number(value_);
 
 }
 
 /// Validates (i.e. returns true or false) and consumes a natural number from the input string.
-/*! This method parses a valid natural number from the input.
+/*! This method parses a valid natural number from the input and accumulates its value.
  *
  * Production rule is:
  * ```
  * <natural_number> := <digit_excl_zero>,{<digit>};
  * ```
+ * Values too large for required_int_type are saturated (see Numeric::accumulate()), so that they are still
+ * reported as out of range, no matter how many digits the number has.
  *
+ * @param value_ receives the value of the natural number.
  * @return true if a natural number has been successfuly parsed from the input; false otherwise.
  */
-Parser::ResultType Parser::natural_number() {
+Parser::ResultType Parser::natural_number(input_int_type &value_) {
     bool resultado = digit_excl_zero();
     if (!resultado)
         return ResultType(ResultType::ILL_FORMED_INTEGER,
-                          static_cast<ResultType::size_type>(std::distance(expr.begin(), it_curr_symb) + 1));
-    while (resultado) {
-        resultado = digit();
-    }
+                          static_cast<ResultType::size_type>(std::distance(expr_begin, it_curr_symb) + 1));
+
+    // The remaining {<digit>} are consumed as a single run.
+    const char *first = curr_ptr() - 1;
+    const char *last = Scanner::skip_digits(first + 1, expr_end);
+    it_curr_symb = last;
+
+    value_ = 0;
+    for (; first != last; ++first)
+        value_ = Numeric::accumulate(value_, *first - '0');
     return ResultType(ResultType::OK);
 }
 
-/// Validates (i.e. returns true or false) and consumes a non-zero digit from the input string.
-/*! This method parses a single valid non-zero digit from the input.
- *
+/// Consumes an identifier from the input string and returns the index of its variable.
+/*!
  * Production rule is:
  * ```
- * <digit_excl_zero> := "1" | "2" | "3" | "4" | "5" | "6" | "7" | "8" | "9";
+ * <identifier> := <letter>,{<letter>|<digit>};
  * ```
- *
- * @return true if a non-zero digit has been successfuly parsed from the input; false otherwise.
+ * The first use of a name adds it to variables(); later uses get the same index.
  */
-bool Parser::digit_excl_zero() {
-    return accept(terminal_symbol_t::TS_NON_ZERO_DIGIT);
+Token::value_type Parser::identifier() {
+    const char *first = curr_ptr();
+    next_symbol();
+    while (peek(terminal_symbol_t::TS_LETTER) or peek(terminal_symbol_t::TS_ZERO)
+           or peek(terminal_symbol_t::TS_NON_ZERO_DIGIT))
+        next_symbol();
+    std::size_t length = static_cast<std::size_t>(curr_ptr() - first);
+
+    for (std::size_t i = 0; i < variable_names.size(); ++i)
+        if (variable_names[i].compare(0, std::string::npos, first, length) == 0)
+            return static_cast<Token::value_type>(i);
+    variable_names.emplace_back(first, length);
+    return static_cast<Token::value_type>(variable_names.size() - 1);
 }
 
-/// Validates (i.e. returns true or false) and consumes a zero digit from the input string.
-/*! This method parses a single valid digit from the input.
+/// Validates (i.e. returns true or false) and consumes a non-zero digit from the input string.
+/*! This method parses a single valid non-zero digit from the input.
  *
  * Production rule is:
  * ```
- * <digit> := "0"| <digit_excl_zero>;
+ * <digit_excl_zero> := "1" | "2" | "3" | "4" | "5" | "6" | "7" | "8" | "9";
  * ```
  *
- * @return true if a digit has been successfuly parsed from the input; false otherwise.
+ * @return true if a non-zero digit has been successfuly parsed from the input; false otherwise.
  */
-bool Parser::digit() {
-    return (accept(terminal_symbol_t::TS_ZERO) or digit_excl_zero());
+bool Parser::digit_excl_zero() {
+    return accept(terminal_symbol_t::TS_NON_ZERO_DIGIT);
 }
 
 /*!
  * This is the parser's entry point.
- * This method tries to (recursivelly) validate an expression.
+ * This method tries to validate an expression.
  * During this process, we also store the tokens into a container.
  *
- * \param e_ The string with the expression to parse.
+ * The expression is read where it is, without being copied: [first_, last_) only has to stay valid
+ * until parse() returns, since the tokens keep values and columns, not pointers into it.
+ *
+ * \param first_ The first character of the expression to parse.
+ * \param last_ One past the last character.
  * \return The parsing result.
  *
  * @see ResultType
  */
-Parser::ResultType Parser::parse(std::string e_) {
-    expr = std::move(e_);
-    it_curr_symb = expr.begin();
-    token_list.clear();
+Parser::ResultType Parser::parse(const char *first_, const char *last_) {
+    expr_begin = it_curr_symb = first_;
+    expr_end = last_;
+    arena_recycle(token_list, static_cast<std::size_t>(last_ - first_)); // there are never more tokens than characters.
+    variable_names.clear();
     ResultType resultado(ResultType::OK);
     skip_ws();
     if (end_input()) {
         return ResultType(ResultType::UNEXPECTED_END_OF_EXPRESSION,
-                          static_cast<ResultType::size_type>(std::distance(expr.begin(), it_curr_symb) + 1));
+                          static_cast<ResultType::size_type>(std::distance(expr_begin, it_curr_symb) + 1));
     }
     resultado = expression();
     if (resultado.type == ResultType::OK) {
@@ -296,7 +390,7 @@ Parser::ResultType Parser::parse(std::string e_) {
         if (!end_input()) {
             token_list.clear();
             return ResultType(ResultType::EXTRANEOUS_SYMBOL,
-                              static_cast<ResultType::size_type>(std::distance(expr.begin(), it_curr_symb) + 1));
+                              static_cast<ResultType::size_type>(std::distance(expr_begin, it_curr_symb) + 1));
         }
 
     }
@@ -304,7 +398,7 @@ Parser::ResultType Parser::parse(std::string e_) {
 }
 
 /// Return the list of tokens, which is the by-product created during the syntax analysis.
-std::vector<Token> Parser::get_tokens() const {
+Parser::token_list_type Parser::get_tokens() const {
     return token_list;
 }
 
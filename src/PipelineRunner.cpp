@@ -0,0 +1,143 @@
+#include "PipelineRunner.h"
+
+#include <algorithm>  // std::copy
+#include <cerrno>     // errno
+#include <cstring>    // std::memchr, memrchr
+#include <functional> // std::ref
+#include <thread>     // std::thread
+#include <unistd.h>   // read
+
+PipelineRunner::PipelineRunner(std::size_t n_workers, Session::engine_t e_, std::size_t cache_size_,
+                               std::size_t block_size_, std::size_t depth_)
+        : block_size(block_size_ > 0 ? block_size_ : default_block_size) {
+    if (n_workers == 0)
+        n_workers = 1;
+    if (depth_ == 0)
+        depth_ = 1;
+    for (std::size_t i = 0; i < n_workers; ++i) {
+        sessions.emplace_back(new Session(e_, cache_size_));
+        to_workers.emplace_back(new ring_type(depth_ + 1));
+        to_writer.emplace_back(new ring_type(depth_ + 1));
+    }
+    free_blocks.reset(new ring_type(n_workers * depth_));
+    for (std::size_t i = 0; i < n_workers * depth_; ++i) {
+        blocks.emplace_back(new Block);
+        free_blocks->push(blocks.back().get());
+    }
+}
+
+/*!
+ * Fills b_ with the lines that follow in the input: what was left of the previous block,
+ * then one read(2), cut after its last '\n'. A line that does not fit makes the block grow.
+ *
+ * \return false at the end of the input (b_ then holds the last lines, maybe none).
+ */
+bool PipelineRunner::fill(int fd_, Block &b_) {
+    if (b_.text.size() < block_size)
+        b_.text.resize(block_size);
+    if (b_.text.size() <= carry.size())
+        b_.text.resize(2 * carry.size());
+    std::copy(carry.begin(), carry.end(), b_.text.begin());
+    std::size_t len = carry.size();
+    carry.clear();
+
+    while (true) {
+        if (len == b_.text.size())
+            b_.text.resize(2 * len);
+        ssize_t n = ::read(fd_, b_.text.data() + len, b_.text.size() - len);
+        if (n < 0 and errno == EINTR)
+            continue;
+        if (n <= 0) {
+            if (n < 0)
+                error = true;
+            // The last line of the input does not need a '\n'.
+            if (len > 0) {
+                if (len == b_.text.size())
+                    b_.text.resize(len + 1);
+                b_.text[len++] = '\n';
+            }
+            b_.size = len;
+            return false;
+        }
+        auto *nl = static_cast<const char *>(memrchr(b_.text.data() + len, '\n', static_cast<std::size_t>(n)));
+        len += static_cast<std::size_t>(n);
+        if (nl != nullptr) {
+            b_.size = static_cast<std::size_t>(nl - b_.text.data()) + 1;
+            carry.assign(b_.text.data() + b_.size, b_.text.data() + len);
+            return true;
+        }
+    }
+}
+
+//!< Thread leitora: preenche os blocos livres e os distribui entre os workers, em rodízio
+void PipelineRunner::read(int fd_) {
+    std::size_t next = 0;
+    bool more = true;
+    while (more) {
+        Block *b = free_blocks->pop();
+        more = fill(fd_, *b);
+        to_workers[next]->push(b);
+        next = (next + 1) % to_workers.size();
+    }
+    // One end mark per worker, continuing the turn, so the writer meets the first one right after the last block.
+    for (std::size_t i = 0; i < to_workers.size(); ++i) {
+        to_workers[next]->push(nullptr);
+        next = (next + 1) % to_workers.size();
+    }
+}
+
+//!< Worker w_: avalia as linhas de cada bloco, no próprio bloco
+void PipelineRunner::work(std::size_t w_) {
+    Session &session = *sessions[w_];
+    while (Block *b = to_workers[w_]->pop()) {
+        b->out.clear();
+        const char *first = b->text.data();
+        const char *last = first + b->size;
+        while (first != last) {
+            auto *nl = static_cast<const char *>(std::memchr(first, '\n', static_cast<std::size_t>(last - first)));
+            session.run(first, nl, b->out);
+            first = nl + 1;
+        }
+        to_writer[w_]->push(b);
+    }
+    to_writer[w_]->push(nullptr);
+}
+
+//!< Thread escritora: recolhe os blocos na ordem da entrada, escreve e os devolve à leitora
+void PipelineRunner::write(OutputWriter &out_) {
+    for (std::size_t next = 0;; next = (next + 1) % to_writer.size()) {
+        Block *b;
+        if (not to_writer[next]->try_pop(b)) {
+            out_.flush(); // nothing else is ready: what was written so far goes out now.
+            b = to_writer[next]->pop();
+        }
+        if (b == nullptr)
+            break;
+        out_.write(b->out.data(), b->out.size());
+        free_blocks->push(b);
+    }
+}
+
+/*!
+ * Evaluates every line of the input.
+ *
+ * \param fd_ The input file descriptor (not closed).
+ * \param out_ Where the results are written, in the same order as the input lines.
+ */
+void PipelineRunner::run(int fd_, OutputWriter &out_) {
+    error = false;
+    carry.clear();
+
+    std::vector<std::thread> threads;
+    threads.emplace_back(&PipelineRunner::read, this, fd_);
+    for (std::size_t w = 0; w < sessions.size(); ++w)
+        threads.emplace_back(&PipelineRunner::work, this, w);
+    threads.emplace_back(&PipelineRunner::write, this, std::ref(out_));
+    for (auto &t : threads)
+        t.join();
+
+    // The writer stops at the first end mark; the others are still in their rings.
+    Block *b;
+    for (auto &ring : to_writer)
+        while (ring->try_pop(b)) {/* empty */}
+}
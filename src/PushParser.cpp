@@ -0,0 +1,234 @@
+#include "PushParser.h"
+
+#include <cstring> // std::memchr
+
+#include "Scanner.h"
+
+/// The binary operator denoted by c_, or operator_t::NONE.
+Token::operator_t PushParser::binary_operator(char c_) {
+    switch (c_) {
+        case '+':
+            return Token::operator_t::PLUS;
+        case '-':
+            return Token::operator_t::MINUS;
+        case '*':
+            return Token::operator_t::TIMES;
+        case '/':
+            return Token::operator_t::SLASH;
+        case '%':
+            return Token::operator_t::MOD;
+        case '^':
+            return Token::operator_t::CIRCUMFLEX;
+        default:
+            return Token::operator_t::NONE;
+    }
+}
+
+//!< Descarta a linha em andamento
+void PushParser::clear() {
+    state = state_t::START;
+    offset = 0;
+    outcome = Parser::ResultType();
+    if (token_list.capacity() > max_kept_tokens)
+        Parser::token_list_type().swap(token_list);
+    else
+        token_list.clear();
+    scopes.clear();
+    scopes_after_operator = 0;
+    after_operator = false;
+}
+
+//!< Registra um erro de sintaxe; o resto da linha é ignorado
+void PushParser::fail(Parser::ResultType::code_t code_, Token::size_type col_) {
+    outcome = Parser::ResultType(code_, col_);
+    state = state_t::SKIP;
+}
+
+/// Opens a "(" at column col_, unless too many are open already.
+void PushParser::open_scope(Token::size_type col_) {
+    if (scopes.size() == max_scopes) {
+        fail(Parser::ResultType::NESTING_TOO_DEEP, col_);
+        return;
+    }
+    token_list.emplace_back(Token::token_t::OPENING_SCOPE, Token::operator_t::NONE, 0, col_);
+    scopes.push_back(after_operator);
+    scopes_after_operator += after_operator;
+    after_operator = false;
+}
+
+/// Closes the innermost "("; returns whether it followed an operator.
+bool PushParser::close_scope() {
+    bool scope_after_operator = scopes.back() != 0;
+    scopes.pop_back();
+    scopes_after_operator -= scope_after_operator;
+    return scope_after_operator;
+}
+
+/// The digits of the current integer are over: stores it, or fails if it is out of range.
+void PushParser::end_integer() {
+    if (value > Numeric::limit(negative)) {
+        fail(Parser::ResultType::INTEGER_OUT_OF_RANGE, term_col);
+        return;
+    }
+    token_list.emplace_back(Token::token_t::OPERAND, Token::operator_t::NONE,
+                            Numeric::from_magnitude(value, negative), term_col);
+    state = state_t::OPERATOR;
+}
+
+/*!
+ * The line ends at column col_: decides its result.
+ *
+ * An error found at the end of the line is turned into MISSING_TERM, as Parser::failure()
+ * does, when the missing term, or any open "(", follows an operator.
+ */
+void PushParser::end_line(Token::size_type col_) {
+    switch (state) {
+        case state_t::START:
+            outcome = Parser::ResultType(Parser::ResultType::UNEXPECTED_END_OF_EXPRESSION, col_);
+            break;
+        case state_t::TERM:
+        case state_t::MINUS:
+            outcome = Parser::ResultType(after_operator or scopes_after_operator > 0
+                                         ? Parser::ResultType::MISSING_TERM
+                                         : Parser::ResultType::ILL_FORMED_INTEGER, col_);
+            break;
+        case state_t::DIGITS:
+            end_integer();
+            if (state == state_t::SKIP)
+                break;
+            // The integer was the last term.
+            // fallthrough
+        case state_t::OPERATOR:
+            if (scopes.empty())
+                outcome = Parser::ResultType(Parser::ResultType::OK);
+            else
+                outcome = Parser::ResultType(close_scope() or scopes_after_operator > 0
+                                             ? Parser::ResultType::MISSING_TERM
+                                             : Parser::ResultType::MISSING_CLOSING, col_);
+            break;
+        default: // SKIP: the error is already known.
+            break;
+    }
+    state = state_t::DONE;
+}
+
+/*!
+ * Parses the next chunk of the input.
+ *
+ * The chunk is consumed up to the end of the current line. If the line ends in it, the
+ * parser stops right after its '\n' and the result is ready(); the rest of the chunk is
+ * for the following calls. Otherwise the whole chunk is consumed and the parser waits,
+ * in the same state, for the next one.
+ *
+ * \param first_ The first byte of the chunk.
+ * \param last_ One past the last byte.
+ * \return One past the last byte consumed.
+ */
+const char *PushParser::push(const char *first_, const char *last_) {
+    if (state == state_t::DONE)
+        clear();
+    auto col = [&](const char *p_) { return static_cast<Token::size_type>(offset + static_cast<std::size_t>(p_ - first_) + 1); };
+
+    const char *p = first_;
+    while (p != last_) {
+        if (state == state_t::SKIP) {
+            p = static_cast<const char *>(std::memchr(p, '\n', static_cast<std::size_t>(last_ - p)));
+            if (p == nullptr) {
+                p = last_;
+                break;
+            }
+        } else if (state != state_t::DIGITS) {
+            p = Scanner::skip_blanks(p, last_);
+            if (p == last_)
+                break;
+        }
+
+        char c = *p;
+        if (c == '\n') {
+            end_line(col(p));
+            offset += static_cast<std::size_t>(p - first_);
+            return p + 1;
+        }
+
+        switch (state) {
+            case state_t::START:
+                state = state_t::TERM;
+                // fallthrough
+            case state_t::TERM:
+                if (c == '(') {
+                    open_scope(col(p));
+                    if (state != state_t::SKIP)
+                        ++p;
+                } else if (c == '0') {
+                    token_list.emplace_back(Token::token_t::OPERAND, Token::operator_t::NONE, 0, col(p));
+                    state = state_t::OPERATOR;
+                    ++p;
+                } else if (c == '-') {
+                    term_col = col(p);
+                    negative = true;
+                    state = state_t::MINUS;
+                    ++p;
+                } else if (c >= '1' and c <= '9') {
+                    term_col = col(p);
+                    negative = false;
+                    value = 0;
+                    state = state_t::DIGITS;
+                } else
+                    fail(Parser::ResultType::ILL_FORMED_INTEGER, col(p));
+                break;
+            case state_t::MINUS:
+                // Each pair of unary minus cancels out.
+                if (c == '-') {
+                    negative = not negative;
+                    ++p;
+                } else if (c >= '1' and c <= '9') {
+                    value = 0;
+                    state = state_t::DIGITS;
+                } else
+                    fail(Parser::ResultType::ILL_FORMED_INTEGER, col(p));
+                break;
+            case state_t::DIGITS:
+                for (; p != last_ and Scanner::is_digit(*p); ++p)
+                    value = Numeric::accumulate(value, *p - '0');
+                if (p != last_)
+                    end_integer();
+                break;
+            case state_t::OPERATOR: {
+                Token::operator_t op = binary_operator(c);
+                if (op != Token::operator_t::NONE) {
+                    token_list.emplace_back(Token::token_t::OPERATOR, op, 0, col(p));
+                    after_operator = true;
+                    state = state_t::TERM;
+                    ++p;
+                } else if (scopes.empty())
+                    fail(Parser::ResultType::EXTRANEOUS_SYMBOL, col(p));
+                else if (c == ')') {
+                    close_scope();
+                    token_list.emplace_back(Token::token_t::CLOSING_SCOPE, Token::operator_t::NONE, 0, col(p));
+                    ++p;
+                } else
+                    fail(Parser::ResultType::MISSING_CLOSING, col(p));
+                break;
+            }
+            default:
+                break;
+        }
+    }
+    offset += static_cast<std::size_t>(last_ - first_);
+    return last_;
+}
+
+/*!
+ * Ends the input. The line in progress, even without its '\n', is ended as Parser::parse()
+ * would end it at the end of the string.
+ *
+ * \return true if there was a line in progress; its result is then ready().
+ */
+bool PushParser::finish() {
+    if (state == state_t::DONE)
+        clear();
+    if (offset == 0)
+        return false;
+    end_line(static_cast<Token::size_type>(offset + 1));
+    return true;
+}
@@ -0,0 +1,78 @@
+#include "ResultCache.h"
+
+#include <iterator> // std::prev
+
+ResultCache::ResultCache(std::size_t capacity_) : max_entries(capacity_ > 0 ? capacity_ : 1) {
+    index.reserve(max_entries);
+}
+
+//!< Procura a entrada de key_ (cujo hash é hash_); devolve entries.end() se não existir
+ResultCache::entry_iterator ResultCache::lookup(const CompiledExpression &key_, std::size_t hash_) {
+    auto range = index.equal_range(hash_);
+    for (auto it = range.first; it != range.second; ++it)
+        if (it->second->key == key_)
+            return it->second;
+    return entries.end();
+}
+
+//!< Remove a entrada it_ do índice
+void ResultCache::unindex(entry_iterator it_) {
+    auto range = index.equal_range(it_->hash);
+    for (auto it = range.first; it != range.second; ++it)
+        if (it->second == it_) {
+            index.erase(it);
+            return;
+        }
+}
+
+/*!
+ * Looks up the result of an expression.
+ *
+ * \param key_ The compiled expression.
+ * \param result_ Receives the cached result on a hit.
+ * \return true on a hit; false otherwise.
+ */
+bool ResultCache::find(const CompiledExpression &key_, Evaluator::EvaluatorResult &result_) {
+    auto it = lookup(key_, key_.hash());
+    if (it == entries.end()) {
+        ++n_misses;
+        return false;
+    }
+    ++n_hits;
+    entries.splice(entries.begin(), entries, it); // torna-se a mais recente
+    result_ = it->result;
+    return true;
+}
+
+/*!
+ * Stores the result of an expression.
+ *
+ * When the cache is full, the least recently used entry is recycled for the new one,
+ * so its memory is reused.
+ *
+ * \param key_ The compiled expression.
+ * \param result_ Its evaluation result.
+ */
+void ResultCache::insert(const CompiledExpression &key_, const Evaluator::EvaluatorResult &result_) {
+    std::size_t h = key_.hash();
+    auto it = lookup(key_, h);
+    if (it != entries.end()) {
+        it->result = result_;
+        entries.splice(entries.begin(), entries, it);
+        return;
+    }
+
+    if (entries.size() >= max_entries) {
+        it = std::prev(entries.end());
+        unindex(it);
+        entries.splice(entries.begin(), entries, it);
+        it->key = key_;
+        ++n_evicted;
+    } else {
+        entries.push_front(Entry{key_, 0, result_});
+        it = entries.begin();
+    }
+    it->hash = h;
+    it->result = result_;
+    index.emplace(h, it);
+}
@@ -0,0 +1,160 @@
+#include "Scanner.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define BARES_SCANNER_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+//=== Lookup table fallback.
+
+const char *blanks_scalar(const char *first_, const char *last_) {
+    while (first_ != last_ and Scanner::is_blank(*first_))
+        ++first_;
+    return first_;
+}
+
+const char *digits_scalar(const char *first_, const char *last_) {
+    while (first_ != last_ and Scanner::is_digit(*first_))
+        ++first_;
+    return first_;
+}
+
+#ifdef BARES_SCANNER_X86
+
+//=== SSE2: 16 bytes per step.
+
+/// Bit i of the result is set if byte i of v_ is ' ' or '\t'.
+inline unsigned blank_mask_sse2(__m128i v_) {
+    __m128i m = _mm_or_si128(_mm_cmpeq_epi8(v_, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v_, _mm_set1_epi8('\t')));
+    return static_cast<unsigned>(_mm_movemask_epi8(m));
+}
+
+/// Bit i of the result is set if byte i of v_ is a digit. Bytes >= 0x80 are negative, so they fail the first test.
+inline unsigned digit_mask_sse2(__m128i v_) {
+    __m128i m = _mm_and_si128(_mm_cmpgt_epi8(v_, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v_, _mm_set1_epi8('9' + 1)));
+    return static_cast<unsigned>(_mm_movemask_epi8(m));
+}
+
+const char *blanks_sse2(const char *first_, const char *last_) {
+    while (last_ - first_ >= 16) {
+        unsigned mask = blank_mask_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(first_)));
+        if (mask != 0xFFFFu)
+            return first_ + __builtin_ctz(~mask);
+        first_ += 16;
+    }
+    return blanks_scalar(first_, last_);
+}
+
+const char *digits_sse2(const char *first_, const char *last_) {
+    while (last_ - first_ >= 16) {
+        unsigned mask = digit_mask_sse2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(first_)));
+        if (mask != 0xFFFFu)
+            return first_ + __builtin_ctz(~mask);
+        first_ += 16;
+    }
+    return digits_scalar(first_, last_);
+}
+
+//=== AVX2: 32 bytes per step.
+
+__attribute__((target("avx2")))
+const char *blanks_avx2(const char *first_, const char *last_) {
+    while (last_ - first_ >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first_));
+        __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                    _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')));
+        auto mask = static_cast<unsigned>(_mm256_movemask_epi8(m));
+        if (mask != 0xFFFFFFFFu)
+            return first_ + __builtin_ctz(~mask);
+        first_ += 32;
+    }
+    return blanks_sse2(first_, last_);
+}
+
+__attribute__((target("avx2")))
+const char *digits_avx2(const char *first_, const char *last_) {
+    while (last_ - first_ >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(first_));
+        __m256i m = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+        auto mask = static_cast<unsigned>(_mm256_movemask_epi8(m));
+        if (mask != 0xFFFFFFFFu)
+            return first_ + __builtin_ctz(~mask);
+        first_ += 32;
+    }
+    return digits_sse2(first_, last_);
+}
+
+#endif // BARES_SCANNER_X86
+
+} // namespace
+
+#define BARES_B Scanner::BLANK
+#define BARES_D Scanner::DIGIT
+const std::uint8_t Scanner::table[256] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, BARES_B, 0, 0, 0, 0, 0, 0,           // 0x00: '\t'
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,                 // 0x10
+        BARES_B, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,           // 0x20: ' '
+        BARES_D, BARES_D, BARES_D, BARES_D, BARES_D, BARES_D, BARES_D, BARES_D, BARES_D, BARES_D,
+        0, 0, 0, 0, 0, 0,                                               // 0x30: '0' - '9'
+        // 0x40 - 0xFF: zero-initialized.
+};
+#undef BARES_B
+#undef BARES_D
+
+Scanner::isa_t Scanner::current = Scanner::isa_t::SCALAR;
+Scanner::scan_fn Scanner::blanks_impl = blanks_scalar;
+Scanner::scan_fn Scanner::digits_impl = digits_scalar;
+
+namespace {
+/// Selects the best instruction set when the program starts.
+const Scanner::isa_t initial_isa = Scanner::set_isa(Scanner::best_isa());
+}
+
+Scanner::isa_t Scanner::best_isa() {
+#ifdef BARES_SCANNER_X86
+    __builtin_cpu_init(); // may run before other static constructors.
+    if (__builtin_cpu_supports("avx2"))
+        return isa_t::AVX2;
+    if (__builtin_cpu_supports("sse2"))
+        return isa_t::SSE2;
+#endif
+    return isa_t::SCALAR;
+}
+
+Scanner::isa_t Scanner::set_isa(isa_t isa_) {
+    if (static_cast<int>(isa_) > static_cast<int>(best_isa()))
+        isa_ = best_isa();
+    switch (isa_) {
+#ifdef BARES_SCANNER_X86
+        case isa_t::AVX2:
+            blanks_impl = blanks_avx2;
+            digits_impl = digits_avx2;
+            break;
+        case isa_t::SSE2:
+            blanks_impl = blanks_sse2;
+            digits_impl = digits_sse2;
+            break;
+#endif
+        default:
+            isa_ = isa_t::SCALAR;
+            blanks_impl = blanks_scalar;
+            digits_impl = digits_scalar;
+            break;
+    }
+    current = isa_;
+    return current;
+}
+
+const char *Scanner::name(isa_t isa_) {
+    switch (isa_) {
+        case isa_t::AVX2:
+            return "avx2";
+        case isa_t::SSE2:
+            return "sse2";
+        default:
+            return "scalar";
+    }
+}
@@ -0,0 +1,340 @@
+#include "Server.h"
+
+#include <cerrno>         // errno
+#include <cstdint>        // std::uint64_t
+#include <cstring>        // std::strerror
+#include <functional>     // std::ref
+#include <thread>         // std::thread
+#include <utility>        // std::move
+#include <sys/epoll.h>    // epoll_create1, epoll_ctl, epoll_wait
+#include <sys/eventfd.h>  // eventfd
+#include <sys/socket.h>   // socket, bind, listen, accept4, send
+#include <sys/stat.h>     // lstat
+#include <sys/un.h>       // sockaddr_un
+#include <unistd.h>       // read, write, close, unlink
+
+namespace {
+
+#ifdef EPOLLEXCLUSIVE
+const std::uint32_t accept_events = EPOLLIN | EPOLLEXCLUSIVE; //!< Wake one loop per new client.
+#else
+const std::uint32_t accept_events = EPOLLIN;
+#endif
+
+/// Registers fd_ in the epoll instance epoll_fd_.
+bool add(int epoll_fd_, int fd_, std::uint32_t events_) {
+    epoll_event e{};
+    e.events = events_;
+    e.data.fd = fd_;
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd_, &e) == 0;
+}
+
+/// Sends as much of [data_, data_ + n_) as the socket takes without blocking; returns the bytes sent,
+/// or -1 if the connection is broken.
+long send_some(int fd_, const char *data_, std::size_t n_) {
+    std::size_t done = 0;
+    while (done < n_) {
+        ssize_t w = ::send(fd_, data_ + done, n_ - done, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (w >= 0)
+            done += static_cast<std::size_t>(w);
+        else if (errno == EINTR)
+            continue;
+        else if (errno == EAGAIN or errno == EWOULDBLOCK)
+            break;
+        else
+            return -1;
+    }
+    return static_cast<long>(done);
+}
+
+} // namespace
+
+Server::Server(std::size_t n_threads, Session::engine_t e_, std::size_t cache_size_) {
+    if (n_threads == 0)
+        n_threads = 1;
+    wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    for (std::size_t i = 0; i < n_threads; ++i) {
+        std::unique_ptr<Loop> loop(new Loop);
+        loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        loop->session.reset(new Session(e_, cache_size_));
+        loop->buf.resize(64 * 1024);
+        // The eventfd is never read: once stop() writes to it, it wakes every loop.
+        if (loop->epoll_fd >= 0 and wake_fd >= 0)
+            add(loop->epoll_fd, wake_fd, EPOLLIN);
+        loops.push_back(std::move(loop));
+    }
+}
+
+Server::~Server() {
+    for (auto &loop : loops) {
+        for (auto &client : loop->clients)
+            close(client.first);
+        if (loop->epoll_fd >= 0)
+            close(loop->epoll_fd);
+    }
+    if (listen_fd >= 0)
+        close(listen_fd);
+    if (wake_fd >= 0)
+        close(wake_fd);
+    if (not path.empty())
+        unlink(path.c_str());
+}
+
+/*!
+ * Creates the listening socket.
+ *
+ * A socket file left behind by a server that did not exit cleanly is replaced; any other
+ * kind of file at path_ is an error.
+ *
+ * \param path_ Path of the socket file.
+ * \param error_ Receives the reason of a failure.
+ * \return true if the server is ready to run().
+ */
+bool Server::listen(const std::string &path_, std::string &error_) {
+    if (wake_fd < 0) {
+        error_ = std::string("eventfd: ") + std::strerror(errno);
+        return false;
+    }
+    for (const auto &loop : loops)
+        if (loop->epoll_fd < 0) {
+            error_ = std::string("epoll: ") + std::strerror(errno);
+            return false;
+        }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path_.empty() or path_.size() >= sizeof(address.sun_path)) {
+        error_ = "caminho inválido para o socket: " + path_;
+        return false;
+    }
+    path_.copy(address.sun_path, path_.size());
+
+    struct stat st{};
+    if (lstat(path_.c_str(), &st) == 0) {
+        if (not S_ISSOCK(st.st_mode)) {
+            error_ = path_ + " já existe e não é um socket";
+            return false;
+        }
+        unlink(path_.c_str());
+    }
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        error_ = std::string("socket: ") + std::strerror(errno);
+        return false;
+    }
+    if (bind(listen_fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+        error_ = path_ + ": " + std::strerror(errno);
+        return false;
+    }
+    path = path_;
+    if (::listen(listen_fd, SOMAXCONN) != 0) {
+        error_ = path_ + ": " + std::strerror(errno);
+        return false;
+    }
+    for (const auto &loop : loops)
+        if (not add(loop->epoll_fd, listen_fd, accept_events)) {
+            error_ = std::string("epoll: ") + std::strerror(errno);
+            return false;
+        }
+    return true;
+}
+
+//!< Atende os clientes até stop() ser chamado; o primeiro laço roda na thread que chamou
+void Server::run() {
+    std::vector<std::thread> threads;
+    for (std::size_t i = 1; i < loops.size(); ++i)
+        threads.emplace_back(&Server::serve, this, std::ref(*loops[i]));
+    serve(*loops[0]);
+    for (auto &t : threads)
+        t.join();
+}
+
+//!< Acorda todos os laços para que terminem
+void Server::stop() {
+    std::uint64_t one = 1;
+    ssize_t ignored = ::write(wake_fd, &one, sizeof(one));
+    (void) ignored;
+}
+
+/// The event loop of one thread.
+void Server::serve(Loop &loop_) {
+    const int max_events = 64;
+    epoll_event events[max_events];
+    while (true) {
+        int n = epoll_wait(loop_.epoll_fd, events, max_events, -1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == wake_fd)
+                goto stopped;
+            if (fd == listen_fd) {
+                accept_client(loop_);
+                continue;
+            }
+            auto it = loop_.clients.find(fd);
+            if (it == loop_.clients.end())
+                continue;
+            Connection &c = it->second;
+            std::uint32_t ready = events[i].events;
+
+            bool ok = not (ready & EPOLLERR);
+            if (ok and (ready & (EPOLLIN | EPOLLHUP))) {
+                // A hang-up while the client is not being read means it is gone for good.
+                ok = (c.events & EPOLLIN) ? receive(loop_, fd, c) : not (ready & EPOLLHUP);
+            }
+            if (ok and (ready & EPOLLOUT))
+                ok = send_pending(fd, c);
+            if (ok)
+                ok = watch(loop_, fd, c);
+            if (not ok)
+                disconnect(loop_, fd);
+        }
+    }
+stopped:
+    for (auto &client : loop_.clients)
+        close(client.first);
+    loop_.clients.clear();
+}
+
+//!< Aceita um novo cliente e o registra neste laço
+void Server::accept_client(Loop &loop_) {
+    // One client per wake-up, so that a burst of clients is spread over the loops.
+    int fd;
+    do
+        fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    while (fd < 0 and (errno == EINTR or errno == ECONNABORTED));
+    if (fd < 0)
+        return; // EAGAIN: another loop took it; EMFILE and the like: try again on the next wake-up.
+
+    Connection &c = loop_.clients[fd];
+    c.events = EPOLLIN;
+    if (not add(loop_.epoll_fd, fd, c.events)) {
+        loop_.clients.erase(fd);
+        close(fd);
+        return;
+    }
+    n_connections.fetch_add(1, std::memory_order_relaxed);
+}
+
+/*!
+ * Reads what the client sent and answers every complete line in it.
+ *
+ * \return false if the connection must be closed.
+ */
+bool Server::receive(Loop &loop_, int fd_, Connection &c_) {
+    ssize_t n;
+    do
+        n = ::read(fd_, loop_.buf.data(), loop_.buf.size());
+    while (n < 0 and errno == EINTR);
+    if (n < 0)
+        return errno == EAGAIN or errno == EWOULDBLOCK;
+
+    std::size_t count = 0;
+    if (n == 0) {
+        // The client will send nothing else: its last line does not need a '\n'.
+        c_.eof = true;
+        if (c_.parser.finish()) {
+            loop_.session->run(c_.parser, loop_.text);
+            ++count;
+        }
+    } else {
+        const char *first = loop_.buf.data();
+        const char *last = first + n;
+        while (first != last) {
+            first = c_.parser.push(first, last);
+            if (c_.parser.ready()) {
+                loop_.session->run(c_.parser, loop_.text);
+                ++count;
+            }
+        }
+        if (not c_.parser.ready() and c_.parser.line_size() > max_line)
+            return false;
+    }
+    if (count > 0)
+        n_lines.fetch_add(count, std::memory_order_relaxed);
+    return answer(loop_, fd_, c_);
+}
+
+/*!
+ * Sends the answers accumulated in the loop's text. When nothing is pending they go straight
+ * to the socket; what it does not take (or everything, if older answers are still pending)
+ * is kept in the connection.
+ *
+ * \return false if the connection is broken.
+ */
+bool Server::answer(Loop &loop_, int fd_, Connection &c_) {
+    const char *data = loop_.text.data();
+    std::size_t size = loop_.text.size();
+    if (size > 0 and c_.sent == c_.pending.size()) {
+        long w = send_some(fd_, data, size);
+        if (w < 0) {
+            loop_.text.clear();
+            return false;
+        }
+        data += w;
+        size -= static_cast<std::size_t>(w);
+    }
+    if (size > 0) {
+        if (c_.sent > 0 and c_.sent == c_.pending.size()) {
+            c_.pending.clear();
+            c_.sent = 0;
+        }
+        c_.pending.insert(c_.pending.end(), data, data + size);
+    }
+    loop_.text.clear();
+    return true;
+}
+
+/// Sends the pending answers of c_; returns false if the connection is broken.
+bool Server::send_pending(int fd_, Connection &c_) {
+    if (c_.sent == c_.pending.size())
+        return true;
+    long w = send_some(fd_, c_.pending.data() + c_.sent, c_.pending.size() - c_.sent);
+    if (w < 0)
+        return false;
+    c_.sent += static_cast<std::size_t>(w);
+    if (c_.sent == c_.pending.size()) {
+        c_.pending.clear();
+        c_.sent = 0;
+    }
+    return true;
+}
+
+/*!
+ * Updates the events the loop waits for on fd_: input while the client has not shut down and
+ * is not too far behind in reading its answers, output while answers are pending.
+ *
+ * \return false if the connection is finished (the client shut down and got every answer).
+ */
+bool Server::watch(Loop &loop_, int fd_, Connection &c_) {
+    std::size_t pending = c_.pending.size() - c_.sent;
+    if (c_.eof and pending == 0)
+        return false;
+
+    std::uint32_t events = 0;
+    if (not c_.eof and pending < max_pending)
+        events |= EPOLLIN;
+    if (pending > 0)
+        events |= EPOLLOUT;
+    if (events == c_.events)
+        return true;
+
+    epoll_event e{};
+    e.events = events;
+    e.data.fd = fd_;
+    if (epoll_ctl(loop_.epoll_fd, EPOLL_CTL_MOD, fd_, &e) != 0)
+        return false;
+    c_.events = events;
+    return true;
+}
+
+//!< Fecha a conexão e descarta o seu estado
+void Server::disconnect(Loop &loop_, int fd_) {
+    loop_.clients.erase(fd_);
+    close(fd_); // also removes it from the epoll instance.
+}
@@ -0,0 +1,137 @@
+#include "Session.h"
+
+namespace {
+/// Text of each syntax error, around its column, in the order of Parser::ResultType::code_t.
+const SyntaxMessage syntax_messages[] = {
+        {"", ""},
+        {"Unexpected end of expression at column (", ")!"},
+        {"Ill formed integer at column (", ")!"},
+        {"Missing <term> at column (", ")!"},
+        {"Extraneous symbol after valid expression found at column (", ")!"},
+        {"Missing closing \")\" at column (", ")!"},
+        {"Integer constant out of range beginning at column (", ")!"},
+        {"Nesting too deep at column (", ")!"}};
+}
+
+const SyntaxMessage &syntax_message(Parser::ResultType::code_t code_) {
+    return syntax_messages[code_];
+}
+
+const char *evaluation_message(Evaluator::EvaluatorResult::code code_) {
+    switch (code_) {
+        case Evaluator::EvaluatorResult::DIVISION_BY_ZERO:
+            return "Division by zero!";
+        case Evaluator::EvaluatorResult::NUMERIC_OVERFLOW:
+            return "Numeric overflow error!";
+        default:
+            return "";
+    }
+}
+
+//!< Imprime mensagens auxiliares de erro do bares
+void print_msg_bares(const Evaluator::EvaluatorResult &result, OutputWriter &out) {
+    if (result.type_b == Evaluator::EvaluatorResult::OK)
+        return;
+    out.write(evaluation_message(result.type_b));
+    out.end_line();
+}
+
+//!< Imprime mensagens de erro de sintaxe da expressão
+void print_msg(const Parser::ResultType &result, OutputWriter &out) {
+    if (result.type == Parser::ResultType::OK)
+        return;
+    const SyntaxMessage &msg = syntax_message(result.type);
+    out.write(msg.prefix);
+    out.write_int(static_cast<long long>(result.at_col));
+    out.write(msg.suffix);
+    out.end_line();
+}
+
+//!< Imprime o resultado de uma linha: erro de sintaxe, erro de avaliação ou o valor
+void print_result(const Parser::ResultType &parsed, const Evaluator::EvaluatorResult &result, OutputWriter &out) {
+    if (parsed.type != Parser::ResultType::OK)
+        print_msg(parsed, out);
+    else if (result.type_b != Evaluator::EvaluatorResult::OK)
+        print_msg_bares(result, out);
+    else {
+        out.write_int(result.value_b);
+        out.end_line();
+    }
+}
+
+Session::Session(engine_t e_, std::size_t cache_size_) : engine(e_), parser(&memory), evaluator(&memory) {
+    if (cache_size_ > 0)
+        result_cache.reset(new ResultCache(cache_size_));
+}
+
+/*!
+ * Evaluates one expression, without printing anything.
+ *
+ * \param first_ The first character of the expression.
+ * \param last_ One past the last character.
+ * \param result_ Receives the value (or the evaluation error) when the expression is valid.
+ * \return The result of the syntax analysis.
+ */
+Parser::ResultType Session::evaluate(const char *first_, const char *last_, Evaluator::EvaluatorResult &result_) {
+    memory.reset(); // nothing from the previous line is used anymore.
+
+    Parser::ResultType result;
+    if (engine == engine_t::FUSED) {
+        result = fused.evaluate(first_, last_, result_);
+        lap(Stats::phase_t::FUSED);
+    } else {
+        result = parser.parse(first_, last_);
+        lap(Stats::phase_t::PARSE);
+        if (result.type == Parser::ResultType::OK)
+            evaluate_tokens(parser.tokens(), result_);
+    }
+    return result;
+}
+
+/*!
+ * Evaluates a line parsed by a PushParser, without printing anything.
+ *
+ * \param parser_ The parser, whose line has just ended.
+ * \param result_ Receives the value (or the evaluation error) when the expression is valid.
+ * \return The result of the syntax analysis.
+ */
+Parser::ResultType Session::evaluate(const PushParser &parser_, Evaluator::EvaluatorResult &result_) {
+    memory.reset();
+    if (parser_.result().type == Parser::ResultType::OK)
+        evaluate_tokens(parser_.tokens(), result_);
+    return parser_.result();
+}
+
+//!< Converte os tokens para posfixa e avalia (ou encontra o resultado no cache)
+void Session::evaluate_tokens(const Parser::token_list_type &tokens_, Evaluator::EvaluatorResult &result_) {
+    evaluator.infix_to_postfix(tokens_, program);
+    lap(Stats::phase_t::POSTFIX);
+    if (not result_cache or not result_cache->find(program, result_)) {
+        result_ = evaluator.evaluate(program);
+        if (result_cache)
+            result_cache->insert(program, result_);
+    }
+    lap(Stats::phase_t::EVALUATE);
+}
+
+//!< Avalia uma linha da entrada e escreve o resultado
+void Session::run(const char *first_, const char *last_, OutputWriter &out_) {
+    Evaluator::EvaluatorResult resultado;
+    Parser::ResultType result = evaluate(first_, last_, resultado);
+    report(result, resultado, out_);
+}
+
+//!< Avalia a linha que o parser_ acabou de ler e escreve o resultado
+void Session::run(const PushParser &parser_, OutputWriter &out_) {
+    Evaluator::EvaluatorResult resultado;
+    Parser::ResultType result = evaluate(parser_, resultado);
+    report(result, resultado, out_);
+}
+
+//!< Escreve o resultado de uma linha e o registra nas estatísticas
+void Session::report(const Parser::ResultType &parsed_, const Evaluator::EvaluatorResult &result_, OutputWriter &out_) {
+    print_result(parsed_, result_, out_);
+    lap(Stats::phase_t::OUTPUT);
+    if (BARES_STATS and stats)
+        stats->end_line(parsed_, result_);
+}
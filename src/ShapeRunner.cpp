@@ -0,0 +1,115 @@
+#include "ShapeRunner.h"
+
+#include "Session.h" // print_result
+
+ShapeRunner::ShapeRunner(std::size_t batch_lines_, std::size_t min_lanes_)
+    : batch_lines(batch_lines_ > 0 ? batch_lines_ : 1), min_lanes(min_lanes_) {
+    batch.reserve(batch_lines);
+}
+
+//!< Coloca a linha line_ (já compilada em program) no grupo da sua forma
+void ShapeRunner::add(std::size_t line_) {
+    key.clear();
+    for (const CompiledExpression::Instruction &ins : program)
+        key.push_back(static_cast<char>(ins.op));
+
+    auto found = index.find(key);
+    std::size_t g;
+    if (found == index.end()) {
+        g = used++;
+        if (g == group.size())
+            group.emplace_back();
+        group[g].shape.clear();
+        group[g].n_operands = 0;
+        for (const CompiledExpression::Instruction &ins : program) {
+            if (ins.op == CompiledExpression::opcode_t::PUSH)
+                group[g].shape.load(static_cast<Token::value_type>(group[g].n_operands++));
+            else
+                group[g].shape.emit(ins.op);
+        }
+        group[g].lanes.clear();
+        group[g].operands.clear();
+        index.emplace(key, g);
+    } else
+        g = found->second;
+
+    Group &target = group[g];
+    target.lanes.push_back(line_);
+    for (const CompiledExpression::Instruction &ins : program)
+        if (ins.op == CompiledExpression::opcode_t::PUSH)
+            target.operands.push_back(ins.operand);
+}
+
+//!< Avalia todas as linhas de um grupo
+void ShapeRunner::evaluate(Group &group_) {
+    std::size_t n = group_.lanes.size();
+    std::size_t k = group_.n_operands;
+
+    if (n < min_lanes) {
+        // Too few lines: each one is evaluated alone, with its row of operands as the variables.
+        n_scalar += n;
+        row_values.resize(k);
+        for (std::size_t lane = 0; lane < n; ++lane) {
+            const lane_type *row = group_.operands.data() + lane * k;
+            for (std::size_t c = 0; c < k; ++c)
+                row_values[c] = row[c];
+            batch[group_.lanes[lane]].result = evaluator.evaluate(group_.shape, row_values.data());
+        }
+        return;
+    }
+
+    // Transposes the rows of operands into columns.
+    n_vectorized += n;
+    column_data.resize(n * k);
+    column_ptrs.resize(k);
+    for (std::size_t c = 0; c < k; ++c)
+        column_ptrs[c] = column_data.data() + c * n;
+    for (std::size_t lane = 0; lane < n; ++lane) {
+        const lane_type *row = group_.operands.data() + lane * k;
+        for (std::size_t c = 0; c < k; ++c)
+            column_data[c * n + lane] = row[c];
+    }
+
+    values.resize(n);
+    codes.resize(n);
+    columns.evaluate(group_.shape, column_ptrs.data(), n, values.data(), codes.data());
+
+    for (std::size_t lane = 0; lane < n; ++lane) {
+        Evaluator::EvaluatorResult &result = batch[group_.lanes[lane]].result;
+        result.type_b = static_cast<Evaluator::EvaluatorResult::code>(codes[lane]);
+        result.value_b = values[lane];
+    }
+}
+
+/*!
+ * Evaluates every line of the input.
+ *
+ * \param reader_ The input source.
+ * \param out_ Where the results are written, in the same order as the input lines.
+ */
+void ShapeRunner::run(LineReader &reader_, OutputWriter &out_) {
+    const char *first, *last; // the current input line, in the reader's buffer
+    bool more = true;
+    while (more) {
+        batch.clear();
+        index.clear();
+        used = 0;
+
+        while (batch.size() < batch_lines and (more = reader_.next(first, last))) {
+            Line line{parser.parse(first, last), Evaluator::EvaluatorResult()};
+            batch.push_back(line);
+            if (line.parsed.type == Parser::ResultType::OK) {
+                evaluator.infix_to_postfix(parser.tokens(), program);
+                add(batch.size() - 1);
+            }
+        }
+        n_lines += batch.size();
+        n_groups += used;
+
+        for (std::size_t g = 0; g < used; ++g)
+            evaluate(group[g]);
+
+        for (const Line &line : batch)
+            print_result(line.parsed, line.result, out_);
+    }
+}
@@ -0,0 +1,159 @@
+#include "Stats.h"
+
+#include <algorithm>  // std::push_heap, std::pop_heap, std::sort
+#include <chrono>     // std::chrono::steady_clock
+#include <functional> // std::greater
+
+#include "Arena.h"
+#include "ResultCache.h"
+
+namespace {
+
+const char *const phase_names[Stats::n_phases] = {"read", "parse", "postfix", "evaluate", "fused", "output"};
+const char *const parse_names[] = {"OK", "UNEXPECTED_END_OF_EXPRESSION", "ILL_FORMED_INTEGER", "MISSING_TERM",
+                                   "EXTRANEOUS_SYMBOL", "MISSING_CLOSING", "INTEGER_OUT_OF_RANGE",
+                                   "NESTING_TOO_DEEP"};
+const char *const eval_names[] = {"OK", "DIVISION_BY_ZERO", "NUMERIC_OVERFLOW"};
+
+} // namespace
+
+Stats::Stats(std::size_t slowest_) : histogram(n_buckets, 0), n_slowest(slowest_) {
+    slowest.reserve(n_slowest + 1);
+}
+
+Stats::nanoseconds Stats::now() {
+    return static_cast<nanoseconds>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+//!< Índice do intervalo do histograma onde fica ns_
+int Stats::bucket(nanoseconds ns_) {
+    if (ns_ < static_cast<nanoseconds>(sub_buckets))
+        return static_cast<int>(ns_);
+    int e = 63 - __builtin_clzll(ns_); // ns_ is in [2^e, 2^(e+1))
+    int m = static_cast<int>(ns_ >> (e - 3)) & (sub_buckets - 1);
+    return (e - 2) * sub_buckets + m;
+}
+
+//!< Limite superior (exclusivo) do intervalo bucket_
+Stats::nanoseconds Stats::bucket_limit(int bucket_) {
+    if (bucket_ < sub_buckets)
+        return static_cast<nanoseconds>(bucket_ + 1);
+    int e = bucket_ / sub_buckets + 2;
+    int m = bucket_ % sub_buckets;
+    return static_cast<nanoseconds>(sub_buckets + m + 1) << (e - 3);
+}
+
+/*!
+ * Records the outcome of the current line.
+ *
+ * \param parsed_ The result of the syntax analysis.
+ * \param result_ The result of the evaluation (used only when parsed_ is OK).
+ */
+void Stats::end_line(const Parser::ResultType &parsed_, const Evaluator::EvaluatorResult &result_) {
+    nanoseconds ns = last - start;
+    ++n_lines;
+    total_ns += ns;
+    if (ns > max_ns)
+        max_ns = ns;
+    ++histogram[static_cast<std::size_t>(bucket(ns))];
+
+    ++parse_codes[parsed_.type];
+    if (parsed_.type == Parser::ResultType::OK)
+        ++eval_codes[result_.type_b];
+
+    // A min-heap of the slowest lines: the fastest of them is at the front, ready to be replaced.
+    if (n_slowest == 0)
+        return;
+    if (slowest.size() < n_slowest or ns > slowest.front().first) {
+        slowest.emplace_back(ns, n_lines);
+        std::push_heap(slowest.begin(), slowest.end(), std::greater<std::pair<nanoseconds, std::size_t>>());
+        if (slowest.size() > n_slowest) {
+            std::pop_heap(slowest.begin(), slowest.end(), std::greater<std::pair<nanoseconds, std::size_t>>());
+            slowest.pop_back();
+        }
+    }
+}
+
+Stats::nanoseconds Stats::percentile(double fraction_) const {
+    if (n_lines == 0)
+        return 0;
+    auto wanted = static_cast<std::size_t>(fraction_ * static_cast<double>(n_lines));
+    if (wanted >= n_lines)
+        wanted = n_lines - 1;
+    std::size_t seen = 0;
+    for (int b = 0; b < n_buckets; ++b) {
+        seen += histogram[static_cast<std::size_t>(b)];
+        if (seen > wanted)
+            return std::min(bucket_limit(b), max_ns);
+    }
+    return max_ns;
+}
+
+void Stats::print_text(std::ostream &os_, const Arena *arena_, const ResultCache *cache_) const {
+    nanoseconds total_phases = 0;
+    for (nanoseconds ns : phase_ns)
+        total_phases += ns;
+
+    os_ << "stats: lines=" << n_lines << " total_ns=" << total_phases << "\n";
+    for (std::size_t p = 0; p < n_phases; ++p)
+        if (phase_ns[p] > 0) {
+            nanoseconds tenths = phase_ns[p] * 1000 / total_phases; // share in tenths of a percent
+            os_ << "stats: phase=" << phase_names[p] << " ns=" << phase_ns[p] << " share=" << tenths / 10 << "."
+                << tenths % 10 << "%\n";
+        }
+    os_ << "stats: latency_ns p50=" << percentile(0.50) << " p90=" << percentile(0.90) << " p99=" << percentile(0.99)
+        << " max=" << max_ns << " mean=" << (n_lines > 0 ? total_ns / n_lines : 0) << "\n";
+
+    os_ << "stats: parse";
+    for (std::size_t c = 0; c < n_parse_codes; ++c)
+        os_ << " " << parse_names[c] << "=" << parse_codes[c];
+    os_ << "\nstats: evaluate";
+    for (std::size_t c = 0; c < n_eval_codes; ++c)
+        os_ << " " << eval_names[c] << "=" << eval_codes[c];
+    os_ << "\n";
+
+    auto top = slowest;
+    std::sort(top.begin(), top.end(), std::greater<std::pair<nanoseconds, std::size_t>>());
+    os_ << "stats: slowest";
+    for (const auto &s : top)
+        os_ << " line" << s.second << "=" << s.first << "ns";
+    os_ << "\n";
+
+    if (arena_)
+        os_ << "stats: arena allocations=" << arena_->allocations() << " system_allocations="
+            << arena_->system_allocations() << " resets=" << arena_->resets() << " capacity=" << arena_->capacity() << "\n";
+    if (cache_)
+        os_ << "stats: cache hits=" << cache_->hits() << " misses=" << cache_->misses() << " evictions="
+            << cache_->evictions() << " entries=" << cache_->size() << "\n";
+}
+
+void Stats::print_json(std::ostream &os_, const Arena *arena_, const ResultCache *cache_) const {
+    os_ << "{\"lines\": " << n_lines << ", \"phases_ns\": {";
+    for (std::size_t p = 0; p < n_phases; ++p)
+        os_ << (p > 0 ? ", " : "") << "\"" << phase_names[p] << "\": " << phase_ns[p];
+    os_ << "}, \"latency_ns\": {\"p50\": " << percentile(0.50) << ", \"p90\": " << percentile(0.90)
+        << ", \"p99\": " << percentile(0.99) << ", \"max\": " << max_ns
+        << ", \"mean\": " << (n_lines > 0 ? total_ns / n_lines : 0) << "}, \"parse\": {";
+    for (std::size_t c = 0; c < n_parse_codes; ++c)
+        os_ << (c > 0 ? ", " : "") << "\"" << parse_names[c] << "\": " << parse_codes[c];
+    os_ << "}, \"evaluate\": {";
+    for (std::size_t c = 0; c < n_eval_codes; ++c)
+        os_ << (c > 0 ? ", " : "") << "\"" << eval_names[c] << "\": " << eval_codes[c];
+    os_ << "}, \"slowest\": [";
+
+    auto top = slowest;
+    std::sort(top.begin(), top.end(), std::greater<std::pair<nanoseconds, std::size_t>>());
+    for (std::size_t i = 0; i < top.size(); ++i)
+        os_ << (i > 0 ? ", " : "") << "{\"line\": " << top[i].second << ", \"ns\": " << top[i].first << "}";
+    os_ << "]";
+
+    if (arena_)
+        os_ << ", \"arena\": {\"allocations\": " << arena_->allocations() << ", \"system_allocations\": "
+            << arena_->system_allocations() << ", \"resets\": " << arena_->resets() << ", \"capacity\": "
+            << arena_->capacity() << "}";
+    if (cache_)
+        os_ << ", \"cache\": {\"hits\": " << cache_->hits() << ", \"misses\": " << cache_->misses()
+            << ", \"evictions\": " << cache_->evictions() << ", \"entries\": " << cache_->size() << "}";
+    os_ << "}\n";
+}
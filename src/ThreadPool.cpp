@@ -0,0 +1,93 @@
+#include "ThreadPool.h"
+
+#include <utility> // std::move
+
+ThreadPool::ThreadPool(std::size_t n_workers) {
+    if (n_workers == 0)
+        n_workers = 1;
+    for (std::size_t i = 0; i < n_workers; ++i)
+        queues.emplace_back(new Queue);
+    for (std::size_t i = 0; i < n_workers; ++i)
+        workers.emplace_back(&ThreadPool::worker_loop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(state_mtx);
+        stopping = true;
+    }
+    work_cv.notify_all();
+    for (auto &w : workers)
+        w.join();
+}
+
+/// Queues task_ on the next worker, round-robin.
+void ThreadPool::submit(task_type task_) {
+    {
+        std::lock_guard<std::mutex> lock(state_mtx);
+        ++pending;
+    }
+    Queue &q = *queues[next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size()];
+    {
+        std::lock_guard<std::mutex> lock(q.mtx);
+        q.tasks.push_back(std::move(task_));
+    }
+    {
+        // queued must change under state_mtx, otherwise a worker could check it and
+        // go to sleep right before the notification below.
+        std::lock_guard<std::mutex> lock(state_mtx);
+        queued.fetch_add(1, std::memory_order_release);
+    }
+    work_cv.notify_one();
+}
+
+/// Blocks until every task submitted so far has finished.
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(state_mtx);
+    done_cv.wait(lock, [this] { return pending == 0; });
+}
+
+/// Takes a task from the worker's own queue (newest first) or steals one from another (oldest first).
+bool ThreadPool::try_pop(std::size_t self_, task_type &task_) {
+    {
+        Queue &own = *queues[self_];
+        std::lock_guard<std::mutex> lock(own.mtx);
+        if (not own.tasks.empty()) {
+            task_ = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    for (std::size_t k = 1; k < queues.size(); ++k) {
+        Queue &victim = *queues[(self_ + k) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mtx);
+        if (not victim.tasks.empty()) {
+            task_ = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+//!< Laço principal de cada thread trabalhadora
+void ThreadPool::worker_loop(std::size_t self_) {
+    task_type task;
+    while (true) {
+        if (try_pop(self_, task)) {
+            task(self_);
+            task = nullptr;
+            std::lock_guard<std::mutex> lock(state_mtx);
+            if (--pending == 0)
+                done_cv.notify_all();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(state_mtx);
+        work_cv.wait(lock, [this] { return stopping or queued.load(std::memory_order_acquire) > 0; });
+        if (stopping and queued.load(std::memory_order_acquire) == 0)
+            return;
+    }
+}
@@ -0,0 +1,138 @@
+#include "bares.h"
+
+#include <cstring> // std::memcpy, std::strlen
+
+#include "OutputWriter.h"
+#include "Session.h"
+
+/// A context is a Session; the expressions are parsed where the caller keeps them.
+struct bares_context {
+    Session session;
+
+    bares_context(Session::engine_t e_, std::size_t cache_size_) : session(e_, cache_size_) {/* empty */}
+};
+
+namespace {
+
+//!< Converte o resultado da sessão para a estrutura da interface C
+void to_result(const Parser::ResultType &parsed_, const Evaluator::EvaluatorResult &evaluated_, bares_result *out_) {
+    out_->column = 0;
+    out_->value = 0;
+    out_->value_high = 0;
+    if (parsed_.type == Parser::ResultType::NESTING_TOO_DEEP) {
+        out_->status = BARES_NESTING_TOO_DEEP;
+        out_->column = static_cast<uint32_t>(parsed_.at_col);
+        return;
+    }
+    if (parsed_.type != Parser::ResultType::OK) {
+        out_->status = static_cast<int32_t>(parsed_.type);
+        out_->column = static_cast<uint32_t>(parsed_.at_col);
+        return;
+    }
+    if (evaluated_.type_b != Evaluator::EvaluatorResult::OK) {
+        out_->status = static_cast<int32_t>(BARES_INTEGER_OUT_OF_RANGE + evaluated_.type_b);
+        return;
+    }
+    out_->status = BARES_OK;
+    Numeric::value_type v = evaluated_.value_b;
+#if BARES_INT_BITS == 128
+    out_->value = static_cast<int64_t>(static_cast<uint64_t>(v));
+    out_->value_high = static_cast<int64_t>(v >> 64);
+#else
+    out_->value = static_cast<int64_t>(v);
+    out_->value_high = v < 0 ? -1 : 0;
+#endif
+}
+
+//!< Avalia [data_, data_ + size_) com o contexto ctx_; nenhuma exceção atravessa a interface C
+void evaluate(bares_context *ctx_, const char *data_, std::size_t size_, bares_result *result_) {
+    try {
+        Evaluator::EvaluatorResult evaluated;
+        Parser::ResultType parsed = ctx_->session.evaluate(data_, data_ + size_, evaluated);
+        to_result(parsed, evaluated, result_);
+    } catch (...) {
+        *result_ = bares_result{BARES_OUT_OF_MEMORY, 0, 0, 0};
+    }
+}
+
+} // namespace
+
+int bares_int_bits(void) {
+    return BARES_INT_BITS;
+}
+
+bares_context *bares_context_new(bares_engine engine, size_t cache_size) {
+    Session::engine_t e = engine == BARES_ENGINE_FUSED ? Session::engine_t::FUSED : Session::engine_t::CLASSIC;
+    try {
+        return new bares_context(e, e == Session::engine_t::CLASSIC ? cache_size : 0);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void bares_context_free(bares_context *ctx) {
+    delete ctx;
+}
+
+void bares_set_max_nesting(bares_context *ctx, size_t max_nesting) {
+    ctx->session.set_max_nesting(max_nesting);
+}
+
+bares_status bares_eval(bares_context *ctx, const char *data, size_t size, bares_result *result) {
+    evaluate(ctx, data, size, result);
+    return static_cast<bares_status>(result->status);
+}
+
+size_t bares_eval_batch(bares_context *ctx, const bares_string *exprs, size_t count, bares_result *results) {
+    size_t ok = 0;
+    for (size_t i = 0; i < count; ++i) {
+        evaluate(ctx, exprs[i].data, exprs[i].size, &results[i]);
+        ok += results[i].status == BARES_OK;
+    }
+    return ok;
+}
+
+size_t bares_format(const bares_result *result, char *buf, size_t size) {
+    // The text is made of up to three parts: message prefix, number (value or column), message suffix.
+    char number[OutputWriter::max_int_chars];
+    char *const number_end = number + OutputWriter::max_int_chars;
+    const char *first = number_end;
+    const char *prefix = "";
+    const char *suffix = "";
+
+    if (result->status == BARES_OK) {
+#if BARES_INT_BITS == 128
+        OutputWriter::int_type v = static_cast<OutputWriter::int_type>(
+                (static_cast<OutputWriter::unsigned_int_type>(static_cast<uint64_t>(result->value_high)) << 64)
+                | static_cast<uint64_t>(result->value));
+#else
+        OutputWriter::int_type v = result->value;
+#endif
+        first = OutputWriter::format_int(number_end, v);
+    } else if ((result->status >= BARES_UNEXPECTED_END_OF_EXPRESSION and result->status <= BARES_INTEGER_OUT_OF_RANGE)
+               or result->status == BARES_NESTING_TOO_DEEP) {
+        const SyntaxMessage &msg = syntax_message(result->status == BARES_NESTING_TOO_DEEP
+                                                  ? Parser::ResultType::NESTING_TOO_DEEP
+                                                  : static_cast<Parser::ResultType::code_t>(result->status));
+        prefix = msg.prefix;
+        first = OutputWriter::format_int(number_end, result->column);
+        suffix = msg.suffix;
+    } else if (result->status == BARES_DIVISION_BY_ZERO or result->status == BARES_NUMERIC_OVERFLOW) {
+        prefix = evaluation_message(static_cast<Evaluator::EvaluatorResult::code>(
+                result->status - BARES_INTEGER_OUT_OF_RANGE));
+    }
+
+    const char *parts[3] = {prefix, first, suffix};
+    size_t lengths[3] = {std::strlen(prefix), static_cast<size_t>(number_end - first), std::strlen(suffix)};
+    size_t total = 0;
+    for (int i = 0; i < 3; ++i) {
+        if (total + 1 < size) {
+            size_t room = size - 1 - total;
+            std::memcpy(buf + total, parts[i], lengths[i] < room ? lengths[i] : room);
+        }
+        total += lengths[i];
+    }
+    if (size > 0)
+        buf[total < size - 1 ? total : size - 1] = '\0';
+    return total;
+}
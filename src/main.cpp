@@ -1,100 +1,278 @@
+#include <algorithm> // max
 #include <iostream>  // cout, endl
 #include <sstream>   // getline
-#include <stack>     // stack
 #include <string>    // string
-#include <iomanip>   //setfill, setw
-#include <fstream>
+#include <cstdlib>   // strtoul
+#include <thread>    // std::thread::hardware_concurrency
+#include <csignal>   // sigaction, SIGINT, SIGTERM
+#include <fcntl.h>   // open
+#include <unistd.h>  // close, STDIN_FILENO
 
-#include "Parser.h"
-#include "Evaluator.h"
+#include "BatchRunner.h"
+#include "CsvRunner.h"
+#include "DagRunner.h"
+#include "LineReader.h"
+#include "OutputWriter.h"
+#include "PipelineRunner.h"
+#include "Server.h"
+#include "Session.h"
+#include "ShapeRunner.h"
+#include "Stats.h"
 
-using value_type = long int;
+//!< Imprime a forma de uso do programa
+void usage() {
+    std::cerr << "Use: ./bares [--jobs N] [--engine classic|fused] [--cache N] [--dag] [--shapes] [--csv EXPR] [--stats [text|json]]\n"
+              << "           [--pipeline] [--line-buffered]\n"
+              << "           <entrada | ->\n"
+              << "       ./bares --serve <socket | -> [--jobs N] [--engine classic|fused] [--cache N]\n"
+              << "  --jobs N        avalia as linhas em N threads, mantendo a ordem da saída\n"
+              << "  --engine NOME   classic: tokens -> posfixa -> avaliação (padrão)\n"
+              << "                  fused: análise e avaliação em uma única passada\n"
+              << "  --cache N       guarda até N resultados (LRU) para expressões repetidas (engine classic);\n"
+              << "                  os contadores de acertos e falhas são impressos em stderr ao final\n"
+              << "  --dag           avalia em lotes, calculando uma única vez cada subexpressão repetida;\n"
+              << "                  o número de nós compartilhados é impresso em stderr ao final\n"
+              << "  --shapes        avalia em lotes, agrupando as linhas com a mesma forma (mesmas operações,\n"
+              << "                  operandos diferentes) e calculando cada grupo coluna a coluna (SIMD)\n"
+              << "  --csv EXPR      avalia EXPR, que pode usar variáveis, sobre cada linha de <entrada> (CSV);\n"
+              << "                  a primeira linha dá o nome das colunas, que são as variáveis\n"
+              << "  --stats [F]     mede o tempo de cada fase, a latência das linhas (p50/p99/máx), as linhas\n"
+              << "                  mais lentas e o número de linhas por código de resultado; imprime em\n"
+              << "                  stderr ao final, em texto (padrão) ou json; não vale com --jobs, --dag,\n"
+              << "                  --shapes e --csv\n"
+              << "  --pipeline      lê, avalia e escreve ao mesmo tempo: uma thread lê a entrada em blocos,\n"
+              << "                  N (--jobs) threads avaliam os blocos (padrão: uma por núcleo) e uma thread\n"
+              << "                  escreve os resultados, na ordem da entrada\n"
+              << "  --line-buffered escreve cada resultado assim que ele é calculado (padrão em terminais);\n"
+              << "                  caso contrário a saída é escrita em blocos\n"
+              << "  --serve PATH    fica no ar atendendo os clientes do socket Unix PATH: cada linha recebida\n"
+              << "                  é respondida com o mesmo texto; N (--jobs) threads de eventos atendem\n"
+              << "                  todas as conexões (padrão: uma por núcleo); termina com SIGINT ou SIGTERM.\n"
+              << "                  Com \"-\" atende a entrada padrão, respondendo cada linha assim que chega\n";
+}
 
-//!< Imprime na tela mensagens auxiliares de erro do bares
-void print_msg_bares(const Evaluator::EvaluatorResult &result) {
-    switch (result.type_b) {
-        case Evaluator::EvaluatorResult::DIVISION_BY_ZERO:
-            std::cout << "Division by zero!\n";
-            break;
-        case Evaluator::EvaluatorResult::NUMERIC_OVERFLOW:
-            std::cout << "Numeric overflow error!\n";
-            break;
-        default:
-            break;
-    }
+//!< Servidor em execução, parado pelos sinais de término
+Server *serving = nullptr;
+
+//!< Tratador de SIGINT e SIGTERM
+void stop_serving(int) {
+    if (serving)
+        serving->stop();
 }
 
-//!< Imprime mensagens de erro de sintaxe da expressão
-void print_msg(const Parser::ResultType &result) {
-    switch (result.type) {
-        case Parser::ResultType::UNEXPECTED_END_OF_EXPRESSION:
-            std::cout << "Unexpected end of expression at column (" << result.at_col << ")!\n";
-            break;
-        case Parser::ResultType::ILL_FORMED_INTEGER:
-            std::cout << "Ill formed integer at column (" << result.at_col << ")!\n";
-            break;
-        case Parser::ResultType::MISSING_TERM:
-            std::cout << "Missing <term> at column (" << result.at_col << ")!\n";
-            break;
-        case Parser::ResultType::EXTRANEOUS_SYMBOL:
-            std::cout << "Extraneous symbol after valid expression found at column (" << result.at_col << ")!\n";
-            break;
-        case Parser::ResultType::MISSING_CLOSING:
-            std::cout << "Missing closing \")\" at column (" << result.at_col << ")!\n";
-            break;
-        case Parser::ResultType::INTEGER_OUT_OF_RANGE:
-            std::cout << "Integer constant out of range beginning at column (" << result.at_col << ")!\n";
-            break;
-        default:
-            break;
-    }
+//!< Imprime os contadores do cache de resultados
+void print_cache_stats(std::size_t hits, std::size_t misses, std::size_t evictions, std::size_t entries) {
+    std::cerr << "cache: hits=" << hits << " misses=" << misses
+              << " evictions=" << evictions << " entries=" << entries << "\n";
 }
 
-//!< Leitura do arquivo
-std::vector<std::string> read_file(const std::string &fileName) {
-    std::vector<std::string> expressions;
-    std::fstream file(fileName);
-    if (file.is_open()) {
-        while (!file.eof()) {
-            std::string line;
-            getline(file, line);
-            expressions.push_back(line);
-        }
-        file.close();
-    } else {
-        std::cerr << "Não foi possível lê o arquivo.\n";
-        exit(1);
+//!< Soma e imprime os contadores dos caches dos workers de um runner
+template <typename Runner>
+void print_cache_stats(const Runner &runner_) {
+    std::size_t hits = 0, misses = 0, evictions = 0, entries = 0;
+    for (std::size_t w = 0; w < runner_.workers(); ++w) {
+        const ResultCache *c = runner_.session(w).cache();
+        hits += c->hits();
+        misses += c->misses();
+        evictions += c->evictions();
+        entries += c->size();
     }
-    return expressions;
+    print_cache_stats(hits, misses, evictions, entries);
 }
 
 //!< Método principal
 int main(int argc, char *argv[]) {
-    if(argc < 2) {
-        std::cerr << "Use: ./bares <entrada>\n";
+    std::size_t jobs = 1;
+    Session::engine_t engine = Session::engine_t::CLASSIC;
+    std::size_t cache_size = 0;
+    bool use_dag = false;
+    bool use_shapes = false;
+    bool use_pipeline = false;
+    bool use_csv = false;
+    std::string csv_expr;
+    bool use_stats = false;
+    bool stats_json = false;
+    bool line_buffered = isatty(STDOUT_FILENO) != 0;
+    bool jobs_given = false;
+    std::string serve_path;
+    std::string fileName;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--jobs" and i + 1 < argc) {
+            jobs = std::strtoul(argv[++i], nullptr, 10);
+            jobs_given = true;
+            if (jobs == 0) {
+                usage();
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--engine" and i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "classic")
+                engine = Session::engine_t::CLASSIC;
+            else if (name == "fused")
+                engine = Session::engine_t::FUSED;
+            else {
+                usage();
+                return EXIT_FAILURE;
+            }
+        } else if (arg == "--cache" and i + 1 < argc) {
+            cache_size = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--line-buffered") {
+            line_buffered = true;
+        } else if (arg == "--dag") {
+            use_dag = true;
+        } else if (arg == "--csv" and i + 1 < argc) {
+            use_csv = true;
+            csv_expr = argv[++i];
+        } else if (arg == "--stats") {
+            use_stats = true;
+            if (i + 1 < argc and (std::string(argv[i + 1]) == "text" or std::string(argv[i + 1]) == "json"))
+                stats_json = std::string(argv[++i]) == "json";
+        } else if (arg == "--shapes") {
+            use_shapes = true;
+        } else if (arg == "--pipeline") {
+            use_pipeline = true;
+        } else if (arg == "--serve" and i + 1 < argc and serve_path.empty()) {
+            serve_path = argv[++i];
+        } else if (fileName.empty() and (arg == "-" or arg[0] != '-')) {
+            fileName = arg;
+        } else {
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+    if (not serve_path.empty()) {
+        if (not fileName.empty() or use_dag or use_shapes or use_csv or use_stats or use_pipeline
+            or (cache_size > 0 and engine != Session::engine_t::CLASSIC)) {
+            usage();
+            return EXIT_FAILURE;
+        }
+        if (serve_path == "-") {
+            // Fallback without a socket: the input is served line by line, each answer sent at once.
+            fileName = "-";
+            line_buffered = true;
+            jobs = 1;
+        }
+    }
+    if (not serve_path.empty() and serve_path != "-") {
+        Server server(jobs_given ? jobs : std::max(1u, std::thread::hardware_concurrency()), engine, cache_size);
+        std::string error;
+        if (not server.listen(serve_path, error)) {
+            std::cerr << "Não foi possível abrir o socket: " << error << "\n";
+            return EXIT_FAILURE;
+        }
+        serving = &server;
+        struct sigaction action{};
+        action.sa_handler = stop_serving;
+        sigemptyset(&action.sa_mask);
+        sigaction(SIGINT, &action, nullptr);
+        sigaction(SIGTERM, &action, nullptr);
+        server.run();
+        serving = nullptr;
+        std::cerr << "serve: connections=" << server.connections() << " lines=" << server.lines() << "\n";
+        return EXIT_SUCCESS;
+    }
+    if (fileName.empty() or (cache_size > 0 and engine != Session::engine_t::CLASSIC)
+        or ((use_dag or use_shapes) and (jobs > 1 or cache_size > 0 or engine != Session::engine_t::CLASSIC))
+        or (use_csv and (jobs > 1 or cache_size > 0 or engine != Session::engine_t::CLASSIC))
+        or (use_dag + use_shapes + use_csv + use_pipeline > 1)
+        or (use_stats and (use_dag or use_shapes or use_csv or use_pipeline or jobs > 1))) {
+        usage();
         return EXIT_FAILURE;
     }
 
-    std::vector<std::string> expressions = read_file(argv[1]);
-
-    Parser my_parser;
+    if (use_stats and not BARES_STATS) {
+        std::cerr << "As estatísticas foram desativadas nesta compilação (BARES_STATS=0).\n";
+        return EXIT_FAILURE;
+    }
 
-    for (std::string &expr : expressions) {
-        Parser::ResultType result = my_parser.parse(expr);
-        if (result.type != Parser::ResultType::OK)
-            print_msg(result);
-        else {
-            std::vector<Token> lista = my_parser.get_tokens();
+    // "-" lê da entrada padrão; arquivos e pipes nomeados são lidos em fluxo.
+    int fd = (fileName == "-") ? STDIN_FILENO : open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Não foi possível lê o arquivo.\n";
+        return EXIT_FAILURE;
+    }
 
-            Evaluator eval;
-            auto resultado = eval.evaluate(lista);
+    LineReader reader(fd);
+    bool read_failed = false; // a runner that reads fd on its own
+    OutputWriter out(STDOUT_FILENO);
+    out.set_line_flush(line_buffered);
 
-            if (resultado.type_b != Evaluator::EvaluatorResult::OK)
-                print_msg_bares(resultado);
+    if (use_csv) {
+        // The expression is parsed and compiled only once, then evaluated over every row.
+        Parser parser;
+        parser.set_identifiers(true);
+        Parser::ResultType parsed = parser.parse(csv_expr);
+        if (parsed.type != Parser::ResultType::OK) {
+            print_msg(parsed, out);
+            out.flush();
+            return EXIT_FAILURE;
+        }
+        Evaluator evaluator;
+        CsvRunner runner(evaluator.compile(parser.tokens()), parser.variables());
+        std::string missing;
+        if (not runner.open(reader, missing)) {
+            std::cerr << "A coluna \"" << missing << "\" não existe na entrada.\n";
+            return EXIT_FAILURE;
+        }
+        runner.run(reader, out);
+    } else if (use_dag) {
+        DagRunner runner;
+        runner.run(reader, out);
+        std::cerr << "dag: lines=" << runner.lines() << " nodes=" << runner.dag().requested()
+                  << " distinct=" << runner.dag().requested() - runner.dag().deduplicated()
+                  << " deduplicated=" << runner.dag().deduplicated() << "\n";
+    } else if (use_shapes) {
+        ShapeRunner runner;
+        runner.run(reader, out);
+        std::cerr << "shapes: lines=" << runner.lines() << " groups=" << runner.groups()
+                  << " vectorized=" << runner.vectorized() << " scalar=" << runner.scalar() << "\n";
+    } else if (use_pipeline) {
+        PipelineRunner runner(jobs_given ? jobs : std::max(1u, std::thread::hardware_concurrency()), engine, cache_size);
+        runner.run(fd, out);
+        read_failed = runner.failed();
+        if (cache_size > 0)
+            print_cache_stats(runner);
+    } else if (jobs > 1) {
+        BatchRunner runner(jobs, engine, cache_size);
+        runner.run(reader, out);
+        if (cache_size > 0)
+            print_cache_stats(runner);
+    } else {
+        // Each line is evaluated where it lies in the reader's buffer.
+        Session session(engine, cache_size);
+        const char *first, *last;
+        if (BARES_STATS and use_stats) {
+            Stats stats;
+            session.set_stats(&stats);
+            while (true) {
+                stats.begin_line();
+                if (not reader.next(first, last))
+                    break;
+                stats.lap(Stats::phase_t::READ);
+                session.run(first, last, out);
+            }
+            if (stats_json)
+                stats.print_json(std::cerr, &session.arena(), session.cache());
             else
-                std::cout << resultado.value_b << std::endl;
+                stats.print_text(std::cerr, &session.arena(), session.cache());
+        } else {
+            while (reader.next(first, last))
+                session.run(first, last, out);
         }
+        if (const ResultCache *c = session.cache())
+            print_cache_stats(c->hits(), c->misses(), c->evictions(), c->size());
+    }
 
+    out.flush();
+    if (fd != STDIN_FILENO)
+        close(fd);
+    if (out.failed())
+        return EXIT_FAILURE;
+    if (reader.failed() or read_failed) {
+        std::cerr << "Não foi possível lê o arquivo.\n";
+        return EXIT_FAILURE;
     }
     return EXIT_SUCCESS;
 }